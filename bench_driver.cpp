@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Драйвер бенчмарка масштабируемости: запускает каждую программу через mpiexec на
+// нескольких числах процессов и размерах задачи с аргументом --phases, собирает строки
+// "PHASE <имя> <секунды>" (см. phase_timer.h), повторяет запуски и выводит медиану и
+// 95-й перцентиль каждой фазы в таблицах сильного и слабого масштабирования (CSV, JSON).
+
+// Программа под нагрузкой. Режим args выбирает путь, который измеряется фазами; размер
+// задачи передаётся флагом size_flag. При слабом масштабировании размер растёт как
+// p^(1 / work_exponent), чтобы работа на процесс не менялась (у ex5 работа ~ n^3).
+// per_rank — размер задаётся на процесс (ex3), а не на всю задачу.
+struct Program {
+    string name;
+    string args;
+    string size_flag;
+    long long strong_size; // Размер задачи сильного масштабирования
+    long long weak_size; // Размер задачи слабого масштабирования на одном процессе
+    int work_exponent;
+    bool per_rank;
+    int min_ranks;
+};
+
+const vector<Program> PROGRAMS = {
+    { "ex1", "--collective", "--n=", 1LL << 24, 1LL << 22, 1, false, 1 },
+    { "ex2", "--output=/dev/null", "--n=", 1LL << 22, 1LL << 20, 1, false, 1 },
+    { "ex3", "--allreduce", "--n=", 1LL << 24, 1LL << 22, 1, true, 2 },
+    { "ex4", "--distributed", "--size=", 1LL << 27, 1LL << 25, 1, false, 1 },
+    { "ex5", "--quiet", "--n=", 2048, 1024, 3, false, 1 },
+};
+
+// Параметры запуска, полученные из командной строки
+struct Options {
+    string mpiexec = "mpiexec"; // Запускающая программа MPI
+    string numproc_flag = "-n"; // Флаг числа процессов
+    string mpiexec_flags; // Дополнительные флаги mpiexec (например, --oversubscribe)
+    string bin_dir = "."; // Каталог с программами ex1 ... ex5
+    vector<int> ranks = { 1, 2, 4 }; // Числа процессов
+    int reps = 5; // Измеряемых повторов каждого запуска
+    int warmup = 1; // Неизмеряемых прогревочных запусков
+    double scale = 1.0; // Множитель размеров задач (для быстрых прогонов)
+    vector<string> programs; // Программы для запуска (пусто — все)
+    string csv; // Файл таблицы CSV (пусто — без записи)
+    string json; // Файл JSON (пусто — без записи)
+};
+
+// Медиана и 95-й перцентиль одной фазы одного запуска
+struct PhaseStats {
+    string phase;
+    double median = 0;
+    double p95 = 0;
+};
+
+// Результат одной точки таблицы: программа, вид масштабирования, p и размер
+struct Row {
+    string scaling;
+    string program;
+    int ranks = 0;
+    long long size = 0;
+    vector<PhaseStats> phases; // Фазы в порядке вывода программы, последней — "total"
+    bool failed = false;
+};
+
+inline Options parse_options(int argc, char** argv);
+inline vector<Row> run_scaling(const Options& opts, const Program& program, bool weak);
+inline void print_table(const vector<Row>& rows);
+inline void write_csv(const string& path, const vector<Row>& rows);
+inline void write_json(const string& path, const vector<Row>& rows);
+
+int main(int argc, char** argv) {
+    const Options opts = parse_options(argc, argv);
+
+    vector<Row> rows;
+    for (const Program& program : PROGRAMS) {
+        const bool selected = opts.programs.empty()
+            || find(opts.programs.begin(), opts.programs.end(), program.name) != opts.programs.end();
+        if (!selected) {
+            continue;
+        }
+        for (bool weak : { false, true }) {
+            const vector<Row> scaling_rows = run_scaling(opts, program, weak);
+            rows.insert(rows.end(), scaling_rows.begin(), scaling_rows.end());
+        }
+    }
+
+    print_table(rows);
+    if (!opts.csv.empty()) {
+        write_csv(opts.csv, rows);
+    }
+    if (!opts.json.empty()) {
+        write_json(opts.json, rows);
+    }
+    const bool failed = any_of(rows.begin(), rows.end(), [](const Row& row) { return row.failed; });
+    return failed ? 1 : 0;
+}
+
+// Список вида 1,2,4
+vector<string> split_list(string_view list) {
+    vector<string> items;
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        items.emplace_back(list.substr(0, comma));
+        list = comma == string_view::npos ? string_view() : list.substr(comma + 1);
+    }
+    return items;
+}
+
+// Разбор аргументов вида --mpiexec=path --numproc-flag=-n --mpiexec-flags="..." --bin-dir=path
+// --ranks=1,2,4 --reps=R --warmup=W --scale=S --programs=ex1,ex5 --csv=path --json=path
+Options parse_options(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg.starts_with("--mpiexec=")) {
+            opts.mpiexec = string(arg.substr(10));
+        }
+        else if (arg.starts_with("--numproc-flag=")) {
+            opts.numproc_flag = string(arg.substr(15));
+        }
+        else if (arg.starts_with("--mpiexec-flags=")) {
+            opts.mpiexec_flags = string(arg.substr(16));
+        }
+        else if (arg.starts_with("--bin-dir=")) {
+            opts.bin_dir = string(arg.substr(10));
+        }
+        else if (arg.starts_with("--ranks=")) {
+            opts.ranks.clear();
+            for (const string& item : split_list(arg.substr(8))) {
+                opts.ranks.push_back(max(1, atoi(item.c_str())));
+            }
+            sort(opts.ranks.begin(), opts.ranks.end());
+        }
+        else if (arg.starts_with("--reps=")) {
+            opts.reps = max(1, atoi(argv[i] + 7));
+        }
+        else if (arg.starts_with("--warmup=")) {
+            opts.warmup = max(0, atoi(argv[i] + 9));
+        }
+        else if (arg.starts_with("--scale=")) {
+            opts.scale = max(1e-6, strtod(argv[i] + 8, nullptr));
+        }
+        else if (arg.starts_with("--programs=")) {
+            opts.programs = split_list(arg.substr(11));
+        }
+        else if (arg.starts_with("--csv=")) {
+            opts.csv = string(arg.substr(6));
+        }
+        else if (arg.starts_with("--json=")) {
+            opts.json = string(arg.substr(7));
+        }
+    }
+    return opts;
+}
+
+// Один запуск программы; возвращает фазы в порядке вывода или пустой список при ошибке
+vector<pair<string, double>> run_once(const string& command) {
+    vector<pair<string, double>> phases;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        return phases;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), pipe) != nullptr) {
+        istringstream in(line);
+        string tag, phase;
+        double seconds;
+        if (in >> tag >> phase >> seconds && tag == "PHASE") {
+            phases.emplace_back(phase, seconds);
+        }
+    }
+    if (pclose(pipe) != 0) {
+        phases.clear();
+    }
+    return phases;
+}
+
+// Медиана и 95-й перцентиль (по ближайшему рангу)
+PhaseStats summarize(const string& phase, vector<double> samples) {
+    sort(samples.begin(), samples.end());
+    const size_t count = samples.size();
+    PhaseStats stats;
+    stats.phase = phase;
+    stats.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    stats.p95 = samples[(size_t)ceil(0.95 * (double)count) - 1];
+    return stats;
+}
+
+// Размер задачи для p процессов в значениях флага программы
+long long problem_size(const Options& opts, const Program& program, bool weak, int ranks) {
+    double size;
+    if (weak) {
+        size = (double)program.weak_size * opts.scale;
+        if (!program.per_rank) {
+            size *= pow((double)ranks, 1.0 / program.work_exponent);
+        }
+    }
+    else {
+        size = (double)program.strong_size * opts.scale;
+        if (program.per_rank) {
+            size /= ranks;
+        }
+    }
+    return max(1LL, llround(size));
+}
+
+// Все точки одного вида масштабирования одной программы
+vector<Row> run_scaling(const Options& opts, const Program& program, bool weak) {
+    vector<Row> rows;
+    for (int ranks : opts.ranks) {
+        if (ranks < program.min_ranks) {
+            continue;
+        }
+        Row row;
+        row.scaling = weak ? "weak" : "strong";
+        row.program = program.name;
+        row.ranks = ranks;
+        row.size = problem_size(opts, program, weak, ranks);
+        ostringstream command;
+        command << opts.mpiexec << " " << opts.numproc_flag << " " << ranks << " " << opts.mpiexec_flags << " "
+            << opts.bin_dir << "/" << program.name << " " << program.args << " " << program.size_flag << row.size
+            << " --phases";
+        cerr << row.scaling << " " << program.name << " p=" << ranks << " size=" << row.size << endl;
+
+        vector<string> order;
+        map<string, vector<double>> samples;
+        for (int rep = 0; rep < opts.warmup + opts.reps && !row.failed; rep++) {
+            const vector<pair<string, double>> phases = run_once(command.str());
+            if (phases.empty()) {
+                cerr << "Error: run failed: " << command.str() << endl;
+                row.failed = true;
+                break;
+            }
+            if (rep < opts.warmup) {
+                continue;
+            }
+            double total = 0;
+            for (const auto& [phase, seconds] : phases) {
+                if (!samples.count(phase)) {
+                    order.push_back(phase);
+                }
+                samples[phase].push_back(seconds);
+                total += seconds;
+            }
+            samples["total"].push_back(total);
+        }
+        if (!row.failed) {
+            order.push_back("total");
+            for (const string& phase : order) {
+                row.phases.push_back(summarize(phase, samples[phase]));
+            }
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+// Ускорение и эффективность фазы относительно наименьшего p той же программы и вида
+// масштабирования. Сильное: ускорение t(p0) / t(p), эффективность — ускорение * p0 / p.
+// Слабое: эффективность t(p0) / t(p), ускорение (масштабированное) — эффективность * p / p0.
+pair<double, double> speedup_efficiency(const vector<Row>& rows, const Row& row, const PhaseStats& stats) {
+    for (const Row& base : rows) {
+        if (base.program != row.program || base.scaling != row.scaling || base.failed) {
+            continue;
+        }
+        for (const PhaseStats& base_stats : base.phases) {
+            if (base_stats.phase != stats.phase || stats.median <= 0) {
+                continue;
+            }
+            const double ratio = base_stats.median / stats.median;
+            const double ranks_ratio = (double)row.ranks / base.ranks;
+            return row.scaling == "strong" ? pair(ratio, ratio / ranks_ratio) : pair(ratio * ranks_ratio, ratio);
+        }
+        break; // Базовая точка — первая успешная строка
+    }
+    return { 0.0, 0.0 };
+}
+
+// Таблица в консоль: только суммарное время каждой точки
+void print_table(const vector<Row>& rows) {
+    cout << "scaling\tprogram\tranks\tsize\tmedian_s\tp95_s\tspeedup\tefficiency" << endl;
+    for (const Row& row : rows) {
+        if (row.failed) {
+            cout << row.scaling << "\t" << row.program << "\t" << row.ranks << "\t" << row.size << "\tFAILED" << endl;
+            continue;
+        }
+        const PhaseStats& total = row.phases.back();
+        const auto [speedup, efficiency] = speedup_efficiency(rows, row, total);
+        cout << row.scaling << "\t" << row.program << "\t" << row.ranks << "\t" << row.size << "\t" << total.median
+            << "\t" << total.p95 << "\t" << fixed << setprecision(2) << speedup << "\t" << efficiency
+            << defaultfloat << setprecision(6) << endl;
+    }
+}
+
+// CSV: строка на каждую фазу каждой точки
+void write_csv(const string& path, const vector<Row>& rows) {
+    ofstream file(path);
+    if (!file) {
+        cerr << "Error: cannot open " << path << endl;
+        return;
+    }
+    file << "scaling,program,ranks,size,phase,median_s,p95_s,speedup,efficiency\n";
+    for (const Row& row : rows) {
+        for (const PhaseStats& stats : row.phases) {
+            const auto [speedup, efficiency] = speedup_efficiency(rows, row, stats);
+            file << row.scaling << "," << row.program << "," << row.ranks << "," << row.size << "," << stats.phase
+                << "," << stats.median << "," << stats.p95 << "," << speedup << "," << efficiency << "\n";
+        }
+    }
+}
+
+// JSON: массив точек, у каждой — объект фаз
+void write_json(const string& path, const vector<Row>& rows) {
+    ofstream file(path);
+    if (!file) {
+        cerr << "Error: cannot open " << path << endl;
+        return;
+    }
+    file << "[\n";
+    for (size_t i = 0; i < rows.size(); i++) {
+        const Row& row = rows[i];
+        file << "  {\"scaling\": \"" << row.scaling << "\", \"program\": \"" << row.program << "\", \"ranks\": "
+            << row.ranks << ", \"size\": " << row.size << ", \"failed\": " << (row.failed ? "true" : "false")
+            << ", \"phases\": {";
+        for (size_t j = 0; j < row.phases.size(); j++) {
+            const PhaseStats& stats = row.phases[j];
+            const auto [speedup, efficiency] = speedup_efficiency(rows, row, stats);
+            file << (j ? ", " : "") << "\"" << stats.phase << "\": {\"median_s\": " << stats.median
+                << ", \"p95_s\": " << stats.p95 << ", \"speedup\": " << speedup << ", \"efficiency\": "
+                << efficiency << "}";
+        }
+        file << "}}" << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    file << "]\n";
+}
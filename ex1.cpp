@@ -1,9 +1,100 @@
 #include <cstddef> // Для std::size_t
+#include <cstdint> // Для std::uint64_t
+#include <cstdlib> // Для std::strtoull
+#include <cstring> // Для std::memcmp и std::memcpy
 #include <iostream> // Для вывода в консоль
+#include <fstream> // Для чтения входного файла
+#include <string> // Для std::string
+#include <string_view> // Для разбора аргументов командной строки
 #include <mpi.h> // Для использования MPI функций
 #include <vector> // Для работы с std::vector
 #include <algorithm> // Для std::max
 #include <limits> // Для std::numeric_limits
+#include <climits> // Для INT_MAX
+#include <thread> // Для гибридного режима MPI + потоки
+#include <sys/resource.h> // Для getrusage (пиковое потребление памяти)
+#include "phase_timer.h" // Для замера фаз в бенчмарке (--phases)
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h> // Для AVX2/AVX-512 ядер max_product
+#define EX1_X86_SIMD 1
+#endif
+
+// Теги сообщений потокового режима
+const int TAG_CHUNK = 10; // Порция данных: count элементов A, затем count элементов B
+
+const int STREAM_SLOTS = 4; // Буферов порций у координатора потокового режима, общих для всех воркеров
+const std::size_t DEFAULT_STREAM_N = std::size_t(1) << 24; // Длина A и B потокового режима по умолчанию
+const std::size_t PRINT_LIMIT = 32; // Векторы длиннее этого не выводятся в консоль
+
+// Режимы работы программы
+enum class Mode {
+  Default, // Исходный режим: весь X на координаторе, блокирующие MPI_Send
+  Stream, // Потоковый режим: порции X читаются из файла или генератора
+  Collective, // Коллективный режим: MPI_Scatterv с участием ранга 0 и MPI_Reduce(MPI_MAX)
+  BenchKernel, // Микробенчмарк ядер max_product на ранге 0
+  Hybrid // Гибридный режим: один ранг на узел, локальная доля делится между потоками
+};
+
+// Параметры запуска, полученные из командной строки
+struct Options {
+  Mode mode = Mode::Default;
+  std::size_t n = 0; // Длина A и B для генератора (0 — значение режима по умолчанию)
+  std::size_t chunk = std::size_t(1) << 16; // Размер порции в элементах
+  std::string file; // Бинарный файл: 2N double (A, затем B), возможно с заголовком
+  bool allreduce = false; // Результат нужен на всех рангах (MPI_Allreduce)
+  unsigned threads = 1; // Потоков на ранг (в гибридном режиме 0 — ядра узла поровну между его рангами)
+  bool phases = false; // Печать длительности фаз для bench_driver
+};
+
+// Разбор аргументов вида --stream|--collective|--hybrid --n=N --chunk=C --file=path
+// --allreduce --threads=T --phases
+Options parse_options(int argc, char **argv) {
+  Options opts;
+  bool threads_given = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--stream") {
+      opts.mode = Mode::Stream;
+    } else if (arg == "--collective") {
+      opts.mode = Mode::Collective;
+    } else if (arg == "--bench-kernel") {
+      opts.mode = Mode::BenchKernel;
+    } else if (arg == "--hybrid") {
+      opts.mode = Mode::Hybrid;
+    } else if (arg == "--allreduce") {
+      opts.allreduce = true;
+    } else if (arg.starts_with("--n=")) {
+      opts.n = std::strtoull(argv[i] + 4, nullptr, 10);
+    } else if (arg.starts_with("--chunk=")) {
+      opts.chunk = std::max<std::size_t>(1, std::strtoull(argv[i] + 8, nullptr, 10));
+    } else if (arg.starts_with("--threads=")) {
+      opts.threads = std::max<unsigned>(1, std::strtoul(argv[i] + 10, nullptr, 10));
+      threads_given = true;
+    } else if (arg.starts_with("--file=")) {
+      opts.file = std::string(arg.substr(7));
+    } else if (arg == "--phases") {
+      opts.phases = true;
+    }
+  }
+  if (opts.mode != Mode::Hybrid) {
+    opts.threads = 1;
+  } else if (!threads_given) {
+    opts.threads = 0; // Число рангов на узле известно только после MPI_Init (node_threads)
+  }
+  return opts;
+}
+
+// Потоков на ранг по умолчанию: ядра узла делятся поровну между рангами этого узла,
+// иначе при нескольких рангах на узел потоки переподписывают ядра
+unsigned node_threads() {
+  MPI_Comm node_comm;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+  int node_size;
+  MPI_Comm_size(node_comm, &node_size);
+  MPI_Comm_free(&node_comm);
+  return std::max(1u, std::thread::hardware_concurrency() / static_cast<unsigned>(node_size));
+}
 
 // Функция для вывода содержимого вектора
 void print_vector(const std::vector<double> &vec) {
@@ -13,29 +104,440 @@ void print_vector(const std::vector<double> &vec) {
   std::cout << std::endl; // Завершаем строку
 }
 
-// Координаторский процесс (ранк 0)
-void coordinator_process(int size) {
-  // Входной вектор X
-  const std::vector<double> X = {1, 2, 3, 4, 5, 6, 7, 10,
-                                 9, 10, 11, 12, 13, 14, 15, 16};
-  if (X.size() % 2 != 0) {
-    std::cerr << "Size vector be even\n";
+// Ядро вычисления максимума покомпонентного произведения A[i] * B[i] на отрезке длины n
+using MaxProductKernel = double (*)(const double *A, const double *B, std::size_t n);
+
+// Скалярная версия. Произведение NaN игнорируется: std::max(local_max, NaN) == local_max
+double max_product_scalar(const double *A, const double *B, std::size_t n) {
+  double local_max = -std::numeric_limits<double>::infinity(); // Устанавливаем минимальное значение
+  for (std::size_t i = 0; i < n; ++i) {
+    local_max = std::max(local_max, A[i] * B[i]); // Вычисляем максимум покомпонентного произведения
+  }
+  return local_max;
+}
+
+#ifdef EX1_X86_SIMD
+// AVX2: четыре независимых аккумулятора по 4 double скрывают задержку vmaxpd.
+// _mm256_max_pd(product, acc) возвращает acc, если product == NaN, и acc при равенстве
+// (в том числе -0.0 и +0.0), то есть ведёт себя так же, как std::max(acc, product).
+__attribute__((target("avx2"))) double max_product_avx2(const double *A, const double *B, std::size_t n) {
+  const __m256d lowest = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+  __m256d acc0 = lowest, acc1 = lowest, acc2 = lowest, acc3 = lowest;
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(A + i), _mm256_loadu_pd(B + i)), acc0);
+    acc1 = _mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(A + i + 4), _mm256_loadu_pd(B + i + 4)), acc1);
+    acc2 = _mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(A + i + 8), _mm256_loadu_pd(B + i + 8)), acc2);
+    acc3 = _mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(A + i + 12), _mm256_loadu_pd(B + i + 12)), acc3);
+  }
+  // Аккумуляторы никогда не содержат NaN, поэтому порядок объединения не важен
+  acc0 = _mm256_max_pd(_mm256_max_pd(acc0, acc1), _mm256_max_pd(acc2, acc3));
+
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, acc0);
+  double local_max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  for (; i < n; ++i) {
+    local_max = std::max(local_max, A[i] * B[i]);
+  }
+  return local_max;
+}
+
+// _mm512_max_pd из заголовков GCC 12 даёт ложное -Wuninitialized, маска из всех
+// единиц вычисляет то же самое без этого предупреждения
+__attribute__((target("avx512f"))) inline __m512d max512(__m512d x, __m512d y) {
+  return _mm512_maskz_max_pd(0xFF, x, y);
+}
+
+// AVX-512: та же схема с аккумуляторами по 8 double
+__attribute__((target("avx512f"))) double max_product_avx512(const double *A, const double *B, std::size_t n) {
+  const __m512d lowest = _mm512_set1_pd(-std::numeric_limits<double>::infinity());
+  __m512d acc0 = lowest, acc1 = lowest, acc2 = lowest, acc3 = lowest;
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    acc0 = max512(_mm512_mul_pd(_mm512_loadu_pd(A + i), _mm512_loadu_pd(B + i)), acc0);
+    acc1 = max512(_mm512_mul_pd(_mm512_loadu_pd(A + i + 8), _mm512_loadu_pd(B + i + 8)), acc1);
+    acc2 = max512(_mm512_mul_pd(_mm512_loadu_pd(A + i + 16), _mm512_loadu_pd(B + i + 16)), acc2);
+    acc3 = max512(_mm512_mul_pd(_mm512_loadu_pd(A + i + 24), _mm512_loadu_pd(B + i + 24)), acc3);
+  }
+  acc0 = max512(max512(acc0, acc1), max512(acc2, acc3));
+
+  alignas(64) double lanes[8];
+  _mm512_store_pd(lanes, acc0);
+  double local_max = -std::numeric_limits<double>::infinity();
+  for (double lane : lanes) {
+    local_max = std::max(local_max, lane);
+  }
+  for (; i < n; ++i) {
+    local_max = std::max(local_max, A[i] * B[i]);
+  }
+  return local_max;
+}
+#endif
+
+// Выбор самого широкого ядра, поддерживаемого процессором
+MaxProductKernel select_max_product_kernel() {
+#ifdef EX1_X86_SIMD
+  if (__builtin_cpu_supports("avx512f")) {
+    return max_product_avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return max_product_avx2;
+  }
+#endif
+  return max_product_scalar;
+}
+
+// Максимум покомпонентного произведения A[i] * B[i] на отрезке длины n
+double max_product(const double *A, const double *B, std::size_t n) {
+  static const MaxProductKernel kernel = select_max_product_kernel();
+  return kernel(A, B, n);
+}
+
+// Максимум произведений, разделённый между threads потоками. Каждый поток считает
+// частичный максимум своего отрезка, частичные максимумы объединяются до MPI-редукции.
+// MPI вызывается только из главного потока (MPI_THREAD_FUNNELED).
+double threaded_max_product(const double *A, const double *B, std::size_t n, unsigned threads) {
+  threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(1, n)));
+  if (threads <= 1) {
+    return max_product(A, B, n);
+  }
+
+  std::vector<double> partial(threads);
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  const auto range = [&](unsigned t) { return n / threads * t + std::min<std::size_t>(t, n % threads); };
+  for (unsigned t = 1; t < threads; ++t) {
+    pool.emplace_back([&, t] { partial[t] = max_product(A + range(t), B + range(t), range(t + 1) - range(t)); });
+  }
+  partial[0] = max_product(A, B, range(1)); // Главный поток берёт первый отрезок
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+  return *std::max_element(partial.begin(), partial.end());
+}
+
+// Пиковое потребление памяти текущим процессом в мегабайтах
+double peak_rss_mb() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0; // ru_maxrss в килобайтах
+}
+
+// Детерминированный генератор элементов X: X[k] зависит только от k
+double generate_value(std::uint64_t k) {
+  // splitmix64 от индекса, результат в диапазоне [-1, 1)
+  std::uint64_t z = k + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  z ^= z >> 31;
+  return static_cast<double>(z >> 11) * 0x1.0p-52 - 1.0;
+}
+
+// Формат входного файла: N double вектора A, затем N double вектора B. Перед ними может
+// стоять заголовок — INPUT_MAGIC и N как uint64; без заголовка файл содержит ровно 2N double.
+const char INPUT_MAGIC[8] = {'E', 'X', '1', 'V', 'E', 'C', '0', '1'};
+const std::size_t INPUT_HEADER_BYTES = sizeof(INPUT_MAGIC) + sizeof(std::uint64_t);
+
+// Расположение данных во входном файле
+struct InputLayout {
+  std::size_t N = 0; // Длина A и B
+  std::size_t data_offset = 0; // Смещение начала A в байтах
+};
+
+// Расположение данных по первым head_bytes байтам файла (не больше INPUT_HEADER_BYTES)
+// и его размеру. Возвращает false, если размер файла не согласуется с форматом.
+bool input_layout(const char *head, std::size_t head_bytes, std::size_t file_bytes, InputLayout &layout) {
+  if (head_bytes == INPUT_HEADER_BYTES && std::memcmp(head, INPUT_MAGIC, sizeof(INPUT_MAGIC)) == 0) {
+    std::uint64_t N;
+    std::memcpy(&N, head + sizeof(INPUT_MAGIC), sizeof(N));
+    layout.N = N;
+    layout.data_offset = INPUT_HEADER_BYTES;
+    return (file_bytes - INPUT_HEADER_BYTES) / (2 * sizeof(double)) >= N;
+  }
+  layout.N = file_bytes / (2 * sizeof(double));
+  layout.data_offset = 0;
+  return file_bytes % (2 * sizeof(double)) == 0;
+}
+
+// Источник данных потокового режима: входной файл или генератор
+class ChunkSource {
+public:
+  explicit ChunkSource(const Options &opts) : N_(opts.n != 0 ? opts.n : DEFAULT_STREAM_N) {
+    if (opts.file.empty()) {
+      return;
+    }
+    file_A_.open(opts.file, std::ios::binary);
+    file_B_.open(opts.file, std::ios::binary);
+    if (!file_A_ || !file_B_) {
+      std::cerr << "Cannot open input file " << opts.file << "\n";
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    file_A_.seekg(0, std::ios::end);
+    const std::size_t bytes = static_cast<std::size_t>(file_A_.tellg());
+    char head[INPUT_HEADER_BYTES];
+    file_A_.seekg(0);
+    file_A_.read(head, static_cast<std::streamsize>(std::min(bytes, INPUT_HEADER_BYTES)));
+    InputLayout layout;
+    if (!input_layout(head, static_cast<std::size_t>(file_A_.gcount()), bytes, layout)) {
+      std::cerr << "Input file must contain an even number of doubles or a header with N\n";
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    N_ = layout.N;
+    file_A_.clear();
+    file_A_.seekg(static_cast<std::streamoff>(layout.data_offset));
+    file_B_.seekg(static_cast<std::streamoff>(layout.data_offset + N_ * sizeof(double)));
+  }
+
+  std::size_t size() const { return N_; }
+
+  // Читает следующие count элементов A и B (файл читается последовательно).
+  // Ошибка или неполное чтение (файл изменился после открытия) завершает программу.
+  void read(std::size_t offset, std::size_t count, double *A, double *B) {
+    if (file_A_.is_open()) {
+      const std::streamsize bytes = static_cast<std::streamsize>(count * sizeof(double));
+      file_A_.read(reinterpret_cast<char *>(A), bytes);
+      file_B_.read(reinterpret_cast<char *>(B), bytes);
+      if (!file_A_ || !file_B_ || file_A_.gcount() != bytes || file_B_.gcount() != bytes) {
+        std::cerr << "Failed to read " << count << " elements at offset " << offset << " from input file\n";
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+      return;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      A[i] = generate_value(offset + i);
+      B[i] = generate_value(N_ + offset + i);
+    }
+  }
+
+private:
+  std::size_t N_;
+  std::ifstream file_A_; // Позиция чтения A
+  std::ifstream file_B_; // Позиция чтения B
+};
+
+// Входные векторы A и B целиком на ранге 0: исходный пример X, генератор (--n) или файл (--file)
+void make_input(const Options &opts, std::vector<double> &A, std::vector<double> &B) {
+  if (opts.n == 0 && opts.file.empty()) {
+    // Входной вектор X
+    const std::vector<double> X = {1, 2, 3, 4, 5, 6, 7, 10,
+                                   9, 10, 11, 12, 13, 14, 15, 16};
+    if (X.size() % 2 != 0) {
+      std::cerr << "Size vector be even\n";
+      MPI_Abort(MPI_COMM_WORLD, 1);
+      return;
+    }
+
+    const size_t N = X.size() / 2; // Длина половины вектора
+    A.assign(X.begin(), X.begin() + N); // Первая половина вектора X
+    B.assign(X.begin() + N, X.end()); // Вторая половина вектора X
+
+    std::cout << "Vector X: ";
+    print_vector(X); // Выводим вектор X
+  } else {
+    ChunkSource source(opts);
+    A.resize(source.size());
+    B.resize(source.size());
+    source.read(0, source.size(), A.data(), B.data());
+  }
+
+  if (A.size() <= PRINT_LIMIT) {
+    std::cout << "Vector A: ";
+    print_vector(A); // Выводим вектор A
+
+    std::cout << "Vector B: ";
+    print_vector(B); // Выводим вектор B
+  }
+}
+
+// Параллельная загрузка входного файла: каждый ранг сам читает свои отрезки A и B
+// коллективным MPI_File_read_at_all (то же блочное распределение, что у MPI_Scatterv),
+// поэтому данные не проходят через ранг 0, а чтение масштабируется с файловой системой.
+// Заголовок читает только ранг 0 и рассылает расположение данных. Возвращает N;
+// ошибка или неполное чтение любого отрезка завершает программу.
+std::size_t read_input_slices(const std::string &path, int rank, int size, std::vector<double> &local_A,
+                              std::vector<double> &local_B) {
+  MPI_File file;
+  if (MPI_File_open(MPI_COMM_WORLD, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+    if (rank == 0) {
+      std::cerr << "Cannot open input file " << path << "\n";
+    }
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  std::uint64_t layout_data[3] = {0, 0, 0}; // N, смещение A, признак ошибки
+  if (rank == 0) {
+    MPI_Offset file_bytes;
+    MPI_File_get_size(file, &file_bytes);
+    char head[INPUT_HEADER_BYTES];
+    const std::size_t head_bytes = std::min(static_cast<std::size_t>(file_bytes), INPUT_HEADER_BYTES);
+    MPI_Status status;
+    int head_read = 0;
+    if (MPI_File_read_at(file, 0, head, static_cast<int>(head_bytes), MPI_CHAR, &status) == MPI_SUCCESS) {
+      MPI_Get_count(&status, MPI_CHAR, &head_read);
+    }
+    InputLayout layout;
+    const bool valid = static_cast<std::size_t>(head_read) == head_bytes &&
+                       input_layout(head, head_bytes, static_cast<std::size_t>(file_bytes), layout);
+    layout_data[0] = layout.N;
+    layout_data[1] = layout.data_offset;
+    layout_data[2] = valid ? 0 : 1;
+  }
+  MPI_Bcast(layout_data, 3, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+  const std::size_t N = layout_data[0];
+  const std::size_t ranks = static_cast<std::size_t>(size);
+  if (layout_data[2] != 0 || N / ranks + 1 > static_cast<std::size_t>(INT_MAX)) {
+    if (rank == 0) {
+      std::cerr << "Input file must contain an even number of doubles or a header with N, "
+                << "at most INT_MAX elements per rank\n";
+    }
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  const std::size_t r = static_cast<std::size_t>(rank);
+  const std::size_t first = N / ranks * r + std::min(r, N % ranks);
+  const std::size_t count = N / ranks + (r < N % ranks ? 1 : 0);
+  local_A.resize(count);
+  local_B.resize(count);
+  const MPI_Offset A_offset = static_cast<MPI_Offset>(layout_data[1] + first * sizeof(double));
+  const MPI_Offset B_offset = A_offset + static_cast<MPI_Offset>(N * sizeof(double));
+  const auto read_slice = [&](MPI_Offset offset, double *data) {
+    MPI_Status status;
+    int read = 0;
+    if (MPI_File_read_at_all(file, offset, data, static_cast<int>(count), MPI_DOUBLE, &status) == MPI_SUCCESS) {
+      MPI_Get_count(&status, MPI_DOUBLE, &read);
+    }
+    return static_cast<std::size_t>(read) == count;
+  };
+  const bool read_A = read_slice(A_offset, local_A.data());
+  const bool read_B = read_slice(B_offset, local_B.data());
+  if (!read_A || !read_B) {
+    std::cerr << "Rank " << rank << ": failed to read " << count << " elements of A and B from " << path << "\n";
     MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  MPI_File_close(&file);
+  return N;
+}
+
+// Статистика ранга потокового режима
+struct StreamStats {
+  double bytes; // Обработано (воркер) или отправлено (координатор) байт
+  double seconds; // Время работы ранга
+  double peak_rss_mb; // Пиковое потребление памяти
+};
+
+// Сбор статистики на ранге 0 и вывод отчёта
+void report_stream_stats(const StreamStats &local, int rank, int size, std::size_t N, double global_max) {
+  std::vector<StreamStats> all(rank == 0 ? size : 0);
+  MPI_Gather(&local, 3, MPI_DOUBLE, all.data(), 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  if (rank != 0) {
     return;
   }
 
-  const size_t N = X.size() / 2; // Длина половины вектора
-  const std::vector<double> A(X.begin(), X.begin() + N); // Первая половина вектора X
-  const std::vector<double> B(X.begin() + N, X.end()); // Вторая половина вектора X
+  std::cout << "max A[i] and B[i]: " << global_max << " (N = " << N << ")" << std::endl;
+  for (int i = 0; i < size; ++i) {
+    std::cout << "Rank " << i << ": " << all[i].bytes / 1e9 << " GB in " << all[i].seconds << " s, "
+              << all[i].bytes / 1e9 / all[i].seconds << " GB/s, peak RSS " << all[i].peak_rss_mb << " MB"
+              << std::endl;
+  }
+}
+
+// Координатор потокового режима: читает X порциями и раздаёт их воркерам по кругу.
+// Буферов порций всего STREAM_SLOTS на всех воркеров: очередная порция читается в тот,
+// чья отправка завершилась первой (MPI_Waitany), поэтому память координатора —
+// O(STREAM_SLOTS * chunk) при любом числе процессов.
+void stream_coordinator(int size, const Options &opts) {
+  ChunkSource source(opts);
+  const std::size_t N = source.size();
+  const std::size_t chunk = opts.chunk;
+  const int workers = size - 1;
+
+  // Буфер порции: count элементов A, за ними count элементов B
+  std::vector<std::vector<double>> buffers(STREAM_SLOTS, std::vector<double>(2 * chunk));
+  std::vector<MPI_Request> requests(STREAM_SLOTS, MPI_REQUEST_NULL);
+
+  const double start_time = MPI_Wtime();
+  const std::size_t num_chunks = (N + chunk - 1) / chunk;
+  for (std::size_t c = 0; c < num_chunks; ++c) {
+    const int worker = static_cast<int>(c % workers);
+    // Первые STREAM_SLOTS порций занимают свободные буферы, дальше ждём любую завершённую
+    // отправку. Воркер держит два приёма выставленными, поэтому отправки не зависают.
+    int slot = static_cast<int>(c);
+    if (c >= static_cast<std::size_t>(STREAM_SLOTS)) {
+      MPI_Waitany(STREAM_SLOTS, requests.data(), &slot, MPI_STATUS_IGNORE);
+    }
+
+    const std::size_t offset = c * chunk;
+    const std::size_t count = std::min(chunk, N - offset);
+    double *buffer = buffers[slot].data();
+    source.read(offset, count, buffer, buffer + count);
+    MPI_Isend(buffer, static_cast<int>(2 * count), MPI_DOUBLE, worker + 1, TAG_CHUNK, MPI_COMM_WORLD,
+              &requests[slot]);
+  }
+  MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+
+  // Пустые сообщения завершают оба ожидающих приёма у каждого воркера
+  for (int i = 1; i < size; ++i) {
+    MPI_Send(nullptr, 0, MPI_DOUBLE, i, TAG_CHUNK, MPI_COMM_WORLD);
+    MPI_Send(nullptr, 0, MPI_DOUBLE, i, TAG_CHUNK, MPI_COMM_WORLD);
+  }
+
+  double local_max = -std::numeric_limits<double>::infinity();
+  double global_max;
+  MPI_Reduce(&local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+  const StreamStats stats{2.0 * N * sizeof(double), MPI_Wtime() - start_time, peak_rss_mb()};
+  report_stream_stats(stats, 0, size, N, global_max);
+  std::cout << "Coordinator buffers: " << STREAM_SLOTS << " x " << chunk << " elements of A and B, "
+            << STREAM_SLOTS * 2.0 * chunk * sizeof(double) / (1024.0 * 1024.0) << " MB" << std::endl;
+}
+
+// Воркер потокового режима: пока обрабатывается одна порция, вторая уже принимается
+void stream_worker(int rank, int size, const Options &opts) {
+  const std::size_t chunk = opts.chunk;
+  std::vector<double> buffers[2] = {std::vector<double>(2 * chunk), std::vector<double>(2 * chunk)};
+  MPI_Request requests[2];
+
+  const double start_time = MPI_Wtime();
+  for (int slot = 0; slot < 2; ++slot) {
+    MPI_Irecv(buffers[slot].data(), static_cast<int>(2 * chunk), MPI_DOUBLE, 0, TAG_CHUNK, MPI_COMM_WORLD,
+              &requests[slot]);
+  }
+
+  double local_max = -std::numeric_limits<double>::infinity();
+  double bytes = 0;
+  for (int slot = 0;; slot ^= 1) {
+    MPI_Status status;
+    MPI_Wait(&requests[slot], &status);
+    int received;
+    MPI_Get_count(&status, MPI_DOUBLE, &received);
+    if (received == 0) {
+      // Второе пустое сообщение уже отправлено координатором
+      MPI_Wait(&requests[slot ^ 1], MPI_STATUS_IGNORE);
+      break;
+    }
+
+    const std::size_t count = static_cast<std::size_t>(received) / 2;
+    const double *buffer = buffers[slot].data();
+    local_max = std::max(local_max, max_product(buffer, buffer + count, count));
+    bytes += static_cast<double>(received) * sizeof(double);
 
-  std::cout << "Vector X: ";
-  print_vector(X); // Выводим вектор X
+    // Буфер свободен: сразу заказываем в него следующую порцию
+    MPI_Irecv(buffers[slot].data(), static_cast<int>(2 * chunk), MPI_DOUBLE, 0, TAG_CHUNK, MPI_COMM_WORLD,
+              &requests[slot]);
+  }
 
-  std::cout << "Vector A: ";
-  print_vector(A); // Выводим вектор A
+  MPI_Reduce(&local_max, nullptr, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 
-  std::cout << "Vector B: ";
-  print_vector(B); // Выводим вектор B
+  const StreamStats stats{bytes, MPI_Wtime() - start_time, peak_rss_mb()};
+  report_stream_stats(stats, rank, size, 0, 0);
+}
+
+// Координаторский процесс (ранк 0)
+void coordinator_process(int size, const Options &opts) {
+  std::vector<double> A, B;
+  make_input(opts, A, B);
+  const size_t N = A.size(); // Длина половины вектора
+  const double start_time = MPI_Wtime();
 
   MPI_Aint N_as_mpi = static_cast<MPI_Aint>(N); // Преобразуем размер N в тип MPI_Aint
 
@@ -64,6 +566,7 @@ void coordinator_process(int size) {
 
   // Выводим максимальное значение
   std::cout << "max A[i] and B[i]: " << global_max << std::endl;
+  std::cout << "Point-to-point time: " << MPI_Wtime() - start_time << " s" << std::endl;
 }
 
 // Воркерский процесс (ранк > 0)
@@ -86,30 +589,194 @@ void worker_process(int rank, int size) {
   MPI_Recv(B.data(), end - start, MPI_DOUBLE, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
   // Выводим данные, которые находятся в текущем процессе
-  std::cout << "Process " << rank << " received A: ";
-  print_vector(A);
-  std::cout << "Process " << rank << " received B: ";
-  print_vector(B);
+  if (N <= PRINT_LIMIT) {
+    std::cout << "Process " << rank << " received A: ";
+    print_vector(A);
+    std::cout << "Process " << rank << " received B: ";
+    print_vector(B);
+  }
 
-  double local_max = -std::numeric_limits<double>::infinity(); // Устанавливаем минимальное значение
   // Находим локальный максимум для A[i] * B[i]
-  for (size_t i = 0; i < A.size(); ++i) {
-    local_max = std::max(local_max, A[i] * B[i]); // Вычисляем максимум покомпонентного произведения
-  }
+  double local_max = max_product(A.data(), B.data(), A.size());
 
   // Отправляем локальный максимум координатору
   MPI_Send(&local_max, 1, MPI_DOUBLE, 0, 3, MPI_COMM_WORLD);
 }
 
+// Коллективный режим: все ранги, включая 0, получают свою долю через MPI_Scatterv
+// (с --file каждый ранг читает её из файла сам), а глобальный максимум собирается одной
+// операцией MPI_Reduce/MPI_Allreduce.
+// В гибридном режиме доля ранга дополнительно делится между opts.threads потоками.
+void collective_process(int rank, int size, const Options &opts) {
+  const bool from_file = !opts.file.empty();
+  std::vector<double> A, B; // Полные векторы только на ранге 0 и только без --file
+  if (rank == 0 && !from_file) {
+    make_input(opts, A, B);
+  }
+  phase_timer::PhaseTimer timer(opts.phases);
+  timer.start();
+  const double start_time = MPI_Wtime();
+
+  std::vector<double> local_A, local_B;
+  if (from_file) {
+    if (read_input_slices(opts.file, rank, size, local_A, local_B) == 0) {
+      if (rank == 0) {
+        std::cerr << "Input file " << opts.file << " contains no elements\n";
+      }
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    timer.mark("load");
+  } else {
+    MPI_Aint N_as_mpi = static_cast<MPI_Aint>(A.size());
+    MPI_Bcast(&N_as_mpi, 1, MPI_AINT, 0, MPI_COMM_WORLD);
+    const std::size_t N = static_cast<std::size_t>(N_as_mpi);
+    if (N > static_cast<std::size_t>(INT_MAX)) {
+      if (rank == 0) {
+        std::cerr << "Collective mode supports at most INT_MAX elements\n";
+      }
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Блочное распределение: первые N % size рангов получают на один элемент больше
+    std::vector<int> counts(size), displs(size);
+    for (int i = 0, offset = 0; i < size; ++i) {
+      counts[i] = static_cast<int>(N / size + (static_cast<std::size_t>(i) < N % size ? 1 : 0));
+      displs[i] = offset;
+      offset += counts[i];
+    }
+
+    local_A.resize(counts[rank]);
+    local_B.resize(counts[rank]);
+    MPI_Scatterv(A.data(), counts.data(), displs.data(), MPI_DOUBLE, local_A.data(), counts[rank], MPI_DOUBLE, 0,
+                 MPI_COMM_WORLD);
+    MPI_Scatterv(B.data(), counts.data(), displs.data(), MPI_DOUBLE, local_B.data(), counts[rank], MPI_DOUBLE, 0,
+                 MPI_COMM_WORLD);
+    timer.mark("scatter");
+  }
+
+  const double local_max = threaded_max_product(local_A.data(), local_B.data(), local_A.size(), opts.threads);
+  timer.mark("compute");
+  double global_max;
+  if (opts.allreduce) {
+    MPI_Allreduce(&local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  } else {
+    MPI_Reduce(&local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  }
+  timer.mark("reduce");
+
+  if (rank == 0) {
+    std::cout << "max A[i] and B[i]: " << global_max << std::endl;
+    std::cout << (opts.mode == Mode::Hybrid ? "Hybrid" : "Collective") << " time: " << MPI_Wtime() - start_time
+              << " s (" << size << " ranks x " << opts.threads << " threads)" << std::endl;
+  }
+}
+
+// Микробенчмарк: элементов в секунду на одно ядро для входов размером с L1, L2, L3 и DRAM
+void bench_kernel() {
+  struct Kernel {
+    const char *name;
+    MaxProductKernel function;
+  };
+  std::vector<Kernel> kernels = {{"scalar", max_product_scalar}};
+#ifdef EX1_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    kernels.push_back({"avx2", max_product_avx2});
+  }
+  if (__builtin_cpu_supports("avx512f")) {
+    kernels.push_back({"avx512", max_product_avx512});
+  }
+#endif
+
+  struct Size {
+    const char *level;
+    std::size_t n; // Элементов в каждом из A и B
+  };
+  const Size sizes[] = {{"L1", std::size_t(1) << 10},
+                        {"L2", std::size_t(1) << 14},
+                        {"L3", std::size_t(1) << 19},
+                        {"DRAM", std::size_t(1) << 25}};
+
+  std::cout << "level,elements,kernel,Gelem/s,result" << std::endl;
+  for (const Size &size : sizes) {
+    std::vector<double> A(size.n), B(size.n);
+    for (std::size_t i = 0; i < size.n; ++i) {
+      A[i] = generate_value(i);
+      B[i] = generate_value(size.n + i);
+    }
+
+    for (const Kernel &kernel : kernels) {
+      // Повторяем, пока не наберётся не меньше 0.2 с, чтобы сгладить шум таймера
+      double result = kernel.function(A.data(), B.data(), size.n);
+      std::size_t repeats = 0;
+      const double start_time = MPI_Wtime();
+      double elapsed = 0;
+      do {
+        result = std::max(result, kernel.function(A.data(), B.data(), size.n));
+        ++repeats;
+        elapsed = MPI_Wtime() - start_time;
+      } while (elapsed < 0.2);
+
+      std::cout << size.level << "," << size.n << "," << kernel.name << ","
+                << static_cast<double>(repeats * size.n) / elapsed / 1e9 << "," << result << std::endl;
+    }
+  }
+}
+
 // Главная функция программы
 int main(int argc, char **argv) {
-  MPI_Init(&argc, &argv); // Инициализация MPI
+  Options opts = parse_options(argc, argv);
 
+  if (opts.mode == Mode::Hybrid) {
+    // Потоки гибридного режима только считают, MPI вызывает главный поток
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    if (provided < MPI_THREAD_FUNNELED) {
+      std::cerr << "MPI library does not provide MPI_THREAD_FUNNELED\n";
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (opts.threads == 0) {
+      opts.threads = node_threads();
+    }
+  } else {
+    MPI_Init(&argc, &argv); // Инициализация MPI
+  }
 
   int rank, size;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank); // Получаем текущий ранк процесса
   MPI_Comm_size(MPI_COMM_WORLD, &size); // Получаем общее количество процессов
 
+  if (opts.mode == Mode::Stream) {
+    if (size < 2) { // Потоковому режиму нужен хотя бы один воркер
+      if (rank == 0) {
+        std::cerr << "Streaming mode needs at least 2 processes\n";
+      }
+      MPI_Finalize();
+      return 1;
+    }
+
+    if (rank == 0) {
+      stream_coordinator(size, opts);
+    } else {
+      stream_worker(rank, size, opts);
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  if (opts.mode == Mode::BenchKernel) { // Бенчмарк однопоточный, остальные ранги простаивают
+    if (rank == 0) {
+      bench_kernel();
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  if (opts.mode == Mode::Collective || opts.mode == Mode::Hybrid) { // Подходит любое число процессов
+    collective_process(rank, size, opts);
+    MPI_Finalize();
+    return 0;
+  }
+
   if (size < 2 || size % 2 != 0) { // Проверяем, что запущено четное количество процессов
     if (rank == 0) { // Только координатор выводит сообщение
       std::cerr << "You need an even number of processes\n";
@@ -119,7 +786,7 @@ int main(int argc, char **argv) {
   }
 
   if (rank == 0) {
-    coordinator_process(size); // Если ранк 0, запускаем координаторскую функцию
+    coordinator_process(size, opts); // Если ранк 0, запускаем координаторскую функцию
   } else {
     worker_process(rank, size); // Если ранк > 0, запускаем воркерскую функцию
   }
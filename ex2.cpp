@@ -2,25 +2,104 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <limits>
+#include <cstdlib>
+#include <string_view>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <array>
+#include <utility>
+#include "phase_timer.h"
 
 using namespace std;
 
 const int MASTER_RANK = 0; // Константа для обозначения мастер-процесса
+const int TAG_TASK = 1; // Пакет точек для рабочего процесса: {начало, количество}
+const int TAG_RESULT = 2; // Результаты пакета от рабочего процесса
+const int TASKS_IN_FLIGHT = 2; // Пакетов, выданных рабочему процессу заранее
+const long long PRINT_LIMIT = 32; // Результаты выводятся поточечно только для малых n
 
-inline void master_process(int num_processes, int n); // Функция для мастер-процесса
-inline void slave_process(int rank, int num_processes, int n); // Функция для рабочих процессов
-double series_sum(double x, double eps); // Функция для вычисления суммы ряда
+// Параметры запуска, полученные из командной строки
+struct Options {
+    int n = 5; // Количество точек для вычисления
+    double a = -1.0; // Начало диапазона
+    double b = 1.0; // Конец диапазона
+    double eps = 1e-3; // Точность вычислений
+    std::string function = "exp"; // Функция, считаемая рядом: exp (exp(-x^2)), sin, cos, erf, log1p
+    bool dynamic = false; // Динамическая раздача пакетов точек вместо MPI_Scatterv
+    int batch = 1024; // Размер пакета точек в динамическом режиме
+    std::string output; // Производственный режим: файл результатов вместо вывода в консоль
+    bool csv = false; // Текстовый файл "x,sum" вместо бинарного массива double
+    bool bench_series = false; // Бенчмарк series_sum вместо основного расчёта
+    long long bench_points = 1 << 22; // Количество точек бенчмарка
+    double bench_range = 10.0; // Точки бенчмарка берутся из [-bench_range, bench_range]
+    bool phases = false; // Печать длительности фаз производственного режима для bench_driver
+    bool bench_engine = false; // Бенчмарк ядер с фиксированным числом членов против адаптивного ряда
+};
+
+// Функция, которую драйверы считают рядом: имя для --function, запись в выводе,
+// точное значение из <cmath> для проверки и пакетное вычисление ряда
+struct SeriesFunctionInfo {
+    const char* option;
+    const char* label;
+    double (*exact)(double x);
+    void (*batch)(const double* points, size_t n, double eps, double* results);
+};
+
+inline Options parse_options(int argc, char** argv); // Разбор аргументов командной строки
+inline void master_process(int num_processes, const Options& opts); // Функция для мастер-процесса
+inline void slave_process(int rank, int num_processes, int n, const SeriesFunctionInfo& function); // Функция для рабочих процессов
+inline void dynamic_master_process(int num_processes, const Options& opts); // Мастер динамического режима
+inline void dynamic_slave_process(int rank, int num_processes, const SeriesFunctionInfo& function); // Рабочий процесс динамического режима
+inline void production_process(int rank, int num_processes, const Options& opts); // Производственный режим
+inline void report_load_balance(int rank, int num_processes, double busy, double idle, long long points);
+double series_sum(double x, double eps, long long* terms = nullptr); // Функция для вычисления суммы ряда
+std::vector<double> series_sum_batch(const std::vector<double>& points, double eps); // Сумма ряда для массива точек
+void series_sum_batch(const double* points, size_t n, double eps, double* results);
+double series_reduced(double y, int k, double eps, long long* terms = nullptr); // Ряд для уменьшенного аргумента
+void bench_series(const Options& opts); // Скорость и точность series_sum относительно exp(-x*x)
+const SeriesFunctionInfo* find_series_function(string_view name); // Функция по имени --function или nullptr
+void bench_engine(const Options& opts); // Фиксированные ядра против адаптивного ряда для всех функций
+double accumulate_error(double max_error, double sum, double exact); // Максимум ошибки с учётом NaN
 
 int main(int argc, char** argv) {
     int rank, num_processes;
-    int n = 5; // Количество точек для вычисления
 
     MPI_Init(&argc, &argv); // Инициализация MPI
     MPI_Comm_rank(MPI_COMM_WORLD, &rank); // Определение ранга текущего процесса
     MPI_Comm_size(MPI_COMM_WORLD, &num_processes); // Определение общего количества процессов
 
-    // Проверка на корректное количество процессов
-    if (num_processes < 2 || num_processes - 1 > n) {
+    const Options opts = parse_options(argc, argv);
+    if (opts.bench_series || opts.bench_engine) {
+        // Бенчмарки однопоточные и выполняются только мастером
+        if (rank == MASTER_RANK) {
+            if (opts.bench_series) {
+                bench_series(opts);
+            }
+            else {
+                bench_engine(opts);
+            }
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    const SeriesFunctionInfo* function = find_series_function(opts.function);
+    if (function == nullptr) {
+        if (rank == 0) {
+            cout << "Error: unknown function " << opts.function << " (expected exp, sin, cos, erf or log1p)" << endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    const int n = opts.n; // Количество точек для вычисления
+
+    // Проверка на корректное количество процессов (производственному режиму хватает одного)
+    if (opts.output.empty() && (num_processes < 2 || (!opts.dynamic && num_processes - 1 > n))) {
         if (rank == 0) {
             cout << "Error: The number of required processes is less than two or" << endl;
             cout << "Error: Number of slave processes exceeds the number of points." << endl;
@@ -29,21 +108,85 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    if (rank == MASTER_RANK) {
-        master_process(num_processes, n); // Запуск мастер-процесса
+    if (!opts.output.empty()) {
+        production_process(rank, num_processes, opts);
+    }
+    else if (opts.dynamic) {
+        if (rank == MASTER_RANK) {
+            dynamic_master_process(num_processes, opts);
+        }
+        else {
+            dynamic_slave_process(rank, num_processes, *function);
+        }
+    }
+    else if (rank == MASTER_RANK) {
+        master_process(num_processes, opts); // Запуск мастер-процесса
     }
     else {
-        slave_process(rank, num_processes, n); // Запуск рабочего процесса
+        slave_process(rank, num_processes, n, *function); // Запуск рабочего процесса
     }
 
     MPI_Finalize(); // Завершение работы MPI
     return 0;
 }
 
-void master_process(int num_processes, int n) {
-    double A = -1.0; // Начало диапазона
-    double B = 1.0; // Конец диапазона
-    double eps = 1e-3; // Точность вычислений
+// Разбор аргументов вида --n=N --a=A --b=B --eps=E --function=NAME --dynamic --batch=K --output=path
+// --csv --phases, --bench-series --points=N --range=R и --bench-engine
+Options parse_options(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        const string_view arg = argv[i];
+        if (arg == "--bench-series") {
+            opts.bench_series = true;
+        }
+        else if (arg.starts_with("--points=")) {
+            opts.bench_points = strtoll(argv[i] + 9, nullptr, 10);
+        }
+        else if (arg.starts_with("--range=")) {
+            opts.bench_range = strtod(argv[i] + 8, nullptr);
+        }
+        else if (arg.starts_with("--eps=")) {
+            opts.eps = strtod(argv[i] + 6, nullptr);
+        }
+        else if (arg.starts_with("--n=")) {
+            opts.n = atoi(argv[i] + 4);
+        }
+        else if (arg.starts_with("--a=")) {
+            opts.a = strtod(argv[i] + 4, nullptr);
+        }
+        else if (arg.starts_with("--b=")) {
+            opts.b = strtod(argv[i] + 4, nullptr);
+        }
+        else if (arg == "--dynamic") {
+            opts.dynamic = true;
+        }
+        else if (arg.starts_with("--batch=")) {
+            opts.batch = max(1, atoi(argv[i] + 8));
+        }
+        else if (arg.starts_with("--output=")) {
+            opts.output = string(arg.substr(9));
+        }
+        else if (arg == "--csv") {
+            opts.csv = true;
+        }
+        else if (arg == "--phases") {
+            opts.phases = true;
+        }
+        else if (arg.starts_with("--function=")) {
+            opts.function = string(arg.substr(11));
+        }
+        else if (arg == "--bench-engine") {
+            opts.bench_engine = true;
+        }
+    }
+    return opts;
+}
+
+void master_process(int num_processes, const Options& opts) {
+    const int n = opts.n; // Количество точек для вычисления
+    double A = opts.a; // Начало диапазона
+    double B = opts.b; // Конец диапазона
+    double eps = opts.eps; // Точность вычислений
     double step = (B - A) / (n - 1); // Шаг между точками
 
     std::vector<double> points(n); // Вектор для хранения точек
@@ -114,32 +257,39 @@ void master_process(int num_processes, int n) {
     }
     cout << "; Master_glob_size2: " << global_results.size() << endl;
 
-    // Вывод результатов вычисления суммы ряда и экспоненциальной функции
-    cout << "Results of calculating the sum of a series and exponential function:\n";
+    // Вывод результатов вычисления суммы ряда и точного значения функции
+    const SeriesFunctionInfo& function = *find_series_function(opts.function);
+    cout << "Results of calculating the sum of a series and " << function.label << ":\n";
     for (int i = 0; i < n; i++) {
-        double exact = exp(-points[i] * points[i]);
+        double exact = function.exact(points[i]);
         cout << "x = " << points[i] << ", Sum of a series = " << global_results[i]
-            << ", exp(-x^2) = " << exact << "\n";
+            << ", " << function.label << " = " << exact << "\n";
     }
+
+    report_load_balance(MASTER_RANK, num_processes, 0.0, 0.0, 0);
 }
 
-void slave_process(int rank, int num_processes, int n) {
+void slave_process(int rank, int num_processes, int n, const SeriesFunctionInfo& function) {
     std::vector<double> local_results; // Вектор для хранения локальных результатов
     double eps = 0; // Точность вычислений
     int points_per_proc = n / (num_processes - 1) + ((rank <= (n % (num_processes - 1))) ? 1 : 0); // Количество точек на процесс
     std::vector<double> local_data(points_per_proc); // Вектор для хранения локальных данных
 
     // Получение точек от мастер-процесса
+    double idle_start = MPI_Wtime();
     MPI_Scatterv(nullptr, nullptr, nullptr, MPI_DOUBLE,
         local_data.data(), points_per_proc, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
 
     // Получение значения eps от мастер-процесса
     MPI_Bcast(&eps, 1, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
 
-    // Вычисление суммы ряда для каждой точки
-    for (double num : local_data) {
-        local_results.push_back(series_sum(num, eps));
-    }
+    double idle = MPI_Wtime() - idle_start;
+
+    // Вычисление суммы ряда для всех точек сразу
+    const double busy_start = MPI_Wtime();
+    local_results.resize(local_data.size());
+    function.batch(local_data.data(), local_data.size(), eps, local_results.data());
+    const double busy = MPI_Wtime() - busy_start;
 
     // Вывод локальных результатов
     for (double num : local_results) {
@@ -148,24 +298,838 @@ void slave_process(int rank, int num_processes, int n) {
     cout << "; size: " << local_results.size() << "; Rank: " << rank << endl;
 
     // Отправка локальных результатов мастер-процессу
+    idle_start = MPI_Wtime();
     MPI_Gatherv(local_results.data(), (int)local_results.size(), MPI_DOUBLE, nullptr, nullptr, nullptr, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
+    idle += MPI_Wtime() - idle_start;
+
+    report_load_balance(rank, num_processes, busy, idle, (long long)local_results.size());
 }
 
-int factorial(int n) {
-    if (n == 0 || n == 1) {
-        return 1;
+// Параметры сетки, общие для всех процессов динамического режима
+struct GridParams {
+    double a; // Начало диапазона
+    double step; // Шаг между точками
+    double eps; // Точность вычислений
+    double batch; // Наибольший размер пакета
+};
+
+// Мастер динамического режима: раздаёт пакеты точек по запросу (self-scheduling).
+// Каждому рабочему процессу заранее выдано TASKS_IN_FLIGHT пакетов, поэтому пока он
+// считает один пакет, следующий уже лежит у него. Результаты пакета принимаются
+// сразу на своё место в global_results.
+void dynamic_master_process(int num_processes, const Options& opts) {
+    const long long n = opts.n;
+    GridParams params{ opts.a, (opts.b - opts.a) / max(1LL, n - 1), opts.eps, (double)opts.batch };
+    MPI_Bcast(&params, 4, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
+
+    std::vector<double> global_results(n);
+    std::vector<std::vector<long long>> assigned(num_processes); // Очередь выданных пакетов каждого процесса
+    long long next_point = 0;
+
+    // Выдаёт процессу следующий пакет или, если точки кончились, пакет нулевой длины
+    auto send_task = [&](int worker) {
+        long long task[2] = { next_point, min<long long>(opts.batch, n - next_point) };
+        MPI_Send(task, 2, MPI_LONG_LONG, worker, TAG_TASK, MPI_COMM_WORLD);
+        if (task[1] > 0) {
+            assigned[worker].push_back(next_point);
+            next_point += task[1];
+        }
+    };
+
+    long long outstanding = 0; // Выданные, но ещё не полученные пакеты
+    for (int k = 0; k < TASKS_IN_FLIGHT; k++) {
+        for (int worker = 1; worker < num_processes; worker++) {
+            const bool has_points = next_point < n;
+            send_task(worker);
+            outstanding += has_points ? 1 : 0;
+        }
+    }
+
+    while (outstanding > 0) {
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &status);
+        const int worker = status.MPI_SOURCE;
+        // Сообщения одного отправителя не обгоняют друг друга: это самый старый пакет процесса
+        const long long start = assigned[worker].front();
+        assigned[worker].erase(assigned[worker].begin());
+
+        int count;
+        MPI_Get_count(&status, MPI_DOUBLE, &count);
+        MPI_Recv(global_results.data() + start, count, MPI_DOUBLE, worker, TAG_RESULT, MPI_COMM_WORLD,
+            MPI_STATUS_IGNORE);
+        outstanding--;
+
+        const bool has_points = next_point < n;
+        send_task(worker);
+        outstanding += has_points ? 1 : 0;
+    }
+
+    const SeriesFunctionInfo& function = *find_series_function(opts.function);
+    double max_error = 0.0; // Отклонение от точного значения функции по всей сетке
+    for (long long i = 0; i < n; i++) {
+        const double x = params.a + i * params.step;
+        max_error = accumulate_error(max_error, global_results[i], function.exact(x));
+        if (n <= PRINT_LIMIT) {
+            cout << "x = " << x << ", Sum of a series = " << global_results[i]
+                << ", " << function.label << " = " << function.exact(x) << "\n";
+        }
+    }
+    cout << "Dynamic schedule: " << n << " points, batch " << opts.batch
+        << ", max |sum - " << function.label << "| = " << max_error << endl;
+
+    report_load_balance(MASTER_RANK, num_processes, 0.0, 0.0, 0);
+}
+
+// Рабочий процесс динамического режима: считает пакеты, пока не получит пакет нулевой длины.
+// Ожидание заданий и отправка результатов учитываются как простой.
+void dynamic_slave_process(int rank, int num_processes, const SeriesFunctionInfo& function) {
+    GridParams params;
+    MPI_Bcast(&params, 4, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
+
+    std::vector<double> local_points;
+    std::vector<double> local_results;
+    double busy = 0.0, idle = 0.0;
+    long long points = 0;
+    int finished = 0; // Получено пакетов нулевой длины
+    while (finished < TASKS_IN_FLIGHT) {
+        double start = MPI_Wtime();
+        long long task[2];
+        MPI_Recv(task, 2, MPI_LONG_LONG, MASTER_RANK, TAG_TASK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        idle += MPI_Wtime() - start;
+        if (task[1] == 0) {
+            finished++;
+            continue;
+        }
+
+        start = MPI_Wtime();
+        local_points.resize(task[1]);
+        for (long long i = 0; i < task[1]; i++) {
+            local_points[i] = params.a + (task[0] + i) * params.step;
+        }
+        local_results.resize(task[1]);
+        function.batch(local_points.data(), local_points.size(), params.eps, local_results.data());
+        busy += MPI_Wtime() - start;
+        points += task[1];
+
+        start = MPI_Wtime();
+        MPI_Send(local_results.data(), (int)task[1], MPI_DOUBLE, MASTER_RANK, TAG_RESULT, MPI_COMM_WORLD);
+        idle += MPI_Wtime() - start;
+    }
+
+    report_load_balance(rank, num_processes, busy, idle, points);
+}
+
+// Производственный режим: точки делятся между всеми процессами, включая мастер.
+// Каждый процесс строит свои точки сам по параметрам сетки, считает их пакетно, а
+// результаты собираются MPI_Gatherv прямо в итоговый массив мастера (его доля уже
+// лежит на месте, MPI_IN_PLACE). Вместо поточечного cout результаты пишутся в файл.
+void production_process(int rank, int num_processes, const Options& opts) {
+    const int n = opts.n;
+    GridParams params{ opts.a, (opts.b - opts.a) / max(1, n - 1), opts.eps, 0.0 };
+    MPI_Bcast(&params, 4, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
+
+    // Блочное распределение: первые n % num_processes процессов получают на точку больше
+    std::vector<int> counts(num_processes), displs(num_processes);
+    for (int i = 0, offset = 0; i < num_processes; i++) {
+        counts[i] = n / num_processes + (i < n % num_processes ? 1 : 0);
+        displs[i] = offset;
+        offset += counts[i];
+    }
+
+    std::vector<double> global_results(rank == MASTER_RANK ? n : 0);
+    std::vector<double> local_points(counts[rank]);
+    std::vector<double> local_results(rank == MASTER_RANK ? 0 : counts[rank]);
+    double* results = rank == MASTER_RANK ? global_results.data() + displs[rank] : local_results.data();
+
+    phase_timer::PhaseTimer timer(opts.phases);
+    timer.start();
+    const double busy_start = MPI_Wtime();
+    for (int i = 0; i < counts[rank]; i++) {
+        local_points[i] = params.a + (double)(displs[rank] + i) * params.step;
     }
-    return n * factorial(n - 1); // Рекурсивное вычисление факториала
+    find_series_function(opts.function)->batch(local_points.data(), local_points.size(), params.eps, results);
+    const double busy = MPI_Wtime() - busy_start;
+    timer.mark("compute");
+
+    const double idle_start = MPI_Wtime();
+    if (rank == MASTER_RANK) {
+        MPI_Gatherv(MPI_IN_PLACE, 0, MPI_DOUBLE, global_results.data(), counts.data(), displs.data(), MPI_DOUBLE,
+            MASTER_RANK, MPI_COMM_WORLD);
+    }
+    else {
+        MPI_Gatherv(results, counts[rank], MPI_DOUBLE, nullptr, nullptr, nullptr, MPI_DOUBLE, MASTER_RANK,
+            MPI_COMM_WORLD);
+    }
+    const double idle = MPI_Wtime() - idle_start;
+    timer.mark("gather");
+
+    if (rank == MASTER_RANK) {
+        const double write_start = MPI_Wtime();
+        FILE* file = fopen(opts.output.c_str(), opts.csv ? "w" : "wb");
+        if (file == nullptr) {
+            cerr << "Error: cannot open " << opts.output << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        if (opts.csv) {
+            // Буферизованная запись без сброса после каждой строки
+            static char buffer[1 << 20];
+            setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+            for (int i = 0; i < n; i++) {
+                fprintf(file, "%.17g,%.17g\n", params.a + (double)i * params.step, global_results[i]);
+            }
+        }
+        else {
+            fwrite(global_results.data(), sizeof(double), global_results.size(), file);
+        }
+        fclose(file);
+        cout << "Wrote " << n << " results to " << opts.output << " in " << MPI_Wtime() - write_start << " s"
+            << endl;
+    }
+    timer.mark("write");
+
+    report_load_balance(rank, num_processes, busy, idle, counts[rank]);
 }
 
-double series_sum(double x, double eps) {
+// Сбор времени счёта и простоя всех процессов и вывод таблицы на мастере
+void report_load_balance(int rank, int num_processes, double busy, double idle, long long points) {
+    double local[3] = { busy, idle, (double)points };
+    std::vector<double> all(rank == MASTER_RANK ? 3 * num_processes : 0);
+    MPI_Gather(local, 3, MPI_DOUBLE, all.data(), 3, MPI_DOUBLE, MASTER_RANK, MPI_COMM_WORLD);
+    if (rank != MASTER_RANK) {
+        return;
+    }
+
+    cout << "rank,points,busy_s,idle_s\n";
+    for (int i = 0; i < num_processes; i++) {
+        cout << i << "," << (long long)all[3 * i + 2] << "," << all[3 * i] << "," << all[3 * i + 1] << "\n";
+    }
+    cout << flush;
+}
+
+// Новый максимум |sum - exact|. std::max отбрасывает NaN, а разошедшийся ряд в точке, где
+// функция определена, должен попасть в отчёт: NaN-ошибка делает максимум NaN насовсем.
+// Совпадающие значения (в том числе бесконечности и NaN вне области функции) дают 0.
+double accumulate_error(double max_error, double sum, double exact) {
+    if (sum == exact || (isnan(sum) && isnan(exact))) {
+        return max_error;
+    }
+    const double error = fabs(sum - exact);
+    return isnan(error) || error > max_error ? error : max_error;
+}
+
+// Сумма ряда exp(-x^2) = sum (-x^2)^n / n!
+//
+// Каждый член получается из предыдущего умножением на -x^2 / n, а сумма копится
+// с компенсацией Ноймайера. При x^2 > 1 ряд знакопеременный с огромными членами,
+// поэтому аргумент сначала уменьшается: y = x^2 / 2^k <= 1, ряд считается для y,
+// а результат k раз возводится в квадрат: exp(-x^2) = exp(-y)^(2^k).
+// Так как d(s^(2^k))/ds <= 2^k при s <= 1, точность для y ужесточается до eps / 2^k.
+// В terms (если задан) добавляется число просуммированных членов.
+double series_sum(double x, double eps, long long* terms) {
+    double y = x * x;
+    if (y > 746.0) {
+        return 0.0; // exp(-x^2) меньше наименьшего денормализованного double
+    }
+
+    int k = 0; // Количество возведений в квадрат
+    if (y > 1.0) {
+        frexp(y, &k);
+        y = ldexp(y, -k); // Точное деление на 2^k, y в [0.5, 1)
+    }
+    return series_reduced(y, k, ldexp(eps, -k), terms);
+}
+
+// Ряд exp(-y) для уже уменьшенного y <= 1 с последующим возведением в квадрат k раз
+double series_reduced(double y, int k, double eps, long long* terms) {
     double sum = 0.0; // Сумма ряда
+    double compensation = 0.0; // Накопленная ошибка округления суммы
     double term = 1.0; // Текущий член ряда
-    int n = 0; // Номер члена ряда
+    double n = 0.0; // Номер члена ряда
     while (fabs(term) > eps) {
-        sum += term;
-        n++;
-        term = pow(-1, n) * pow(x, 2 * n) / factorial(n); // Вычисление следующего члена ряда
+        const double t = sum + term;
+        if (fabs(sum) >= fabs(term)) {
+            compensation += (sum - t) + term;
+        }
+        else {
+            compensation += (term - t) + sum;
+        }
+        sum = t;
+        n += 1.0;
+        term *= -y * (1.0 / n); // Следующий член ряда из предыдущего
+    }
+    if (terms != nullptr) {
+        *terms += static_cast<long long>(n);
+    }
+
+    sum += compensation;
+    for (int i = 0; i < k; i++) {
+        sum *= sum;
     }
     return sum;
 }
+
+// Пакетное вычисление ряда: count уменьшенных аргументов y с общим k
+using SeriesBlockKernel = void (*)(const double* y, size_t count, int k, double eps, double* out);
+
+void series_block_scalar(const double* y, size_t count, int k, double eps, double* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = series_reduced(y[i], k, eps);
+    }
+}
+
+#ifdef __GNUC__
+// Вектор из W double (векторные расширения GCC/Clang)
+template <int W>
+struct SeriesLanes {
+    typedef double type __attribute__((vector_size(W * sizeof(double))));
+    typedef long long mask __attribute__((vector_size(W * sizeof(double))));
+};
+
+// series_reduced для W точек сразу. Полоса, у которой |term| <= eps, дальше ничего
+// не добавляет: при y <= 1 члены по модулю не растут, поэтому такая полоса уже сошлась.
+// |term| монотонно растёт с y (округление монотонно), поэтому все полосы сходятся не
+// позже полосы с наибольшим y, и цикл идёт по её скалярной копии без горизонтальных
+// проверок маски. Операции над каждой полосой те же, что в скалярной версии, так что
+// результат совпадает с series_sum до бита.
+template <int W>
+__attribute__((always_inline)) inline void series_lanes(const double* y_in, int k, double eps, double* out) {
+    using V = typename SeriesLanes<W>::type;
+    using M = typename SeriesLanes<W>::mask;
+    V y;
+    __builtin_memcpy(&y, y_in, sizeof(y));
+    const double y_max = *max_element(y_in, y_in + W);
+    V sum = {}, compensation = {};
+    V term = V{} + 1.0;
+    double term_max = 1.0; // Член ряда полосы с наибольшим y
+    double n = 0.0;
+    while (fabs(term_max) > eps) {
+        const V add = (term < 0 ? -term : term) > eps ? term : V{};
+        const V t = sum + add;
+        const M sum_larger = (sum < 0 ? -sum : sum) >= (add < 0 ? -add : add);
+        compensation += sum_larger ? (sum - t) + add : (add - t) + sum;
+        sum = t;
+        n += 1.0;
+        const double inverse = 1.0 / n; // Одно деление на все полосы
+        term *= -y * inverse;
+        term_max *= -y_max * inverse;
+    }
+
+    sum += compensation;
+    for (int i = 0; i < k; i++) {
+        sum *= sum;
+    }
+    __builtin_memcpy(out, &sum, sizeof(sum));
+}
+
+// Полный блок по W полос; хвост дополняется повтором последней точки
+template <int W>
+__attribute__((always_inline)) inline void series_block(const double* y, size_t count, int k, double eps, double* out) {
+    size_t i = 0;
+    for (; i + W <= count; i += W) {
+        series_lanes<W>(y + i, k, eps, out + i);
+    }
+    if (i < count) {
+        double tail_y[W], tail_out[W];
+        for (size_t j = 0; j < W; j++) {
+            tail_y[j] = y[min(i + j, count - 1)];
+        }
+        series_lanes<W>(tail_y, k, eps, tail_out);
+        copy(tail_out, tail_out + (count - i), out + i);
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx512f"))) void series_block_avx512(const double* y, size_t count, int k, double eps, double* out) {
+    series_block<8>(y, count, k, eps, out);
+}
+
+__attribute__((target("avx2"))) void series_block_avx2(const double* y, size_t count, int k, double eps, double* out) {
+    series_block<4>(y, count, k, eps, out);
+}
+#endif
+
+void series_block_generic(const double* y, size_t count, int k, double eps, double* out) {
+    series_block<2>(y, count, k, eps, out);
+}
+#endif
+
+// Самое широкое ядро, поддерживаемое процессором
+SeriesBlockKernel select_series_kernel() {
+#ifdef __GNUC__
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512f")) {
+        return series_block_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return series_block_avx2;
+    }
+#endif
+    return series_block_generic;
+#else
+    return series_block_scalar;
+#endif
+}
+
+// Сумма ряда для плитки из не более чем SERIES_TILE точек в SIMD-полосах.
+//
+// Точки раскладываются по корзинам (сортировка подсчётом): при x^2 > 1 корзина
+// определяется числом возведений в квадрат k, при x^2 <= 1 — двоичным порядком x^2.
+// Внутри корзины уменьшенные аргументы отличаются не более чем вдвое, поэтому полосам
+// одного блока нужно почти одинаковое число членов ряда.
+const size_t SERIES_TILE = 4096; // Буферы плитки помещаются в L1/L2
+
+void series_sum_tile(const double* points, size_t n, double eps, double* results) {
+    static const SeriesBlockKernel kernel = select_series_kernel();
+    const int MIN_EXPONENT = -7; // x^2 < 2^-8 попадают в одну корзину
+    const int MAX_K = 10; // x^2 <= 746 < 2^10
+    const int FIRST_K_BUCKET = 1 - MIN_EXPONENT + 1; // Корзины 0..FIRST_K_BUCKET-1 — для k = 0
+    const int NUM_BUCKETS = FIRST_K_BUCKET + MAX_K;
+    const unsigned char IRREGULAR = NUM_BUCKETS; // NaN и x^2 > 746: скалярный путь
+
+    // Двоичный порядок y в смысле frexp (y = m * 2^e, m в [0.5, 1)) и y / 2^e, прямо по битам
+    const uint64_t EXPONENT_MASK = 0x7FF0000000000000ull;
+    auto exponent_of = [](double y) { return (int)((bit_cast<uint64_t>(y) >> 52) & 0x7FF) - 1022; };
+    auto reduce = [&](double y) {
+        return y <= 1.0 ? y : bit_cast<double>((bit_cast<uint64_t>(y) & ~EXPONENT_MASK) | (1022ull << 52));
+    };
+
+    unsigned char bucket[SERIES_TILE];
+    size_t offsets[NUM_BUCKETS + 1] = {};
+    for (size_t i = 0; i < n; i++) {
+        const double y = points[i] * points[i];
+        if (!(y <= 746.0)) {
+            bucket[i] = IRREGULAR;
+            results[i] = series_sum(points[i], eps);
+            continue;
+        }
+        const int exponent = exponent_of(y); // Для денормализованных y меньше MIN_EXPONENT
+        bucket[i] = (unsigned char)(y > 1.0 ? FIRST_K_BUCKET + exponent - 1 : clamp(exponent, MIN_EXPONENT, 1) - MIN_EXPONENT);
+        offsets[bucket[i] + 1]++;
+    }
+    for (int b = 0; b < NUM_BUCKETS; b++) {
+        offsets[b + 1] += offsets[b];
+    }
+
+    // Уменьшенные аргументы, упорядоченные по корзинам, и исходные индексы точек
+    double reduced[SERIES_TILE];
+    unsigned short order[SERIES_TILE];
+    size_t fill[NUM_BUCKETS];
+    copy(offsets, offsets + NUM_BUCKETS, fill);
+    for (size_t i = 0; i < n; i++) {
+        if (bucket[i] != IRREGULAR) {
+            const size_t position = fill[bucket[i]]++;
+            reduced[position] = reduce(points[i] * points[i]);
+            order[position] = (unsigned short)i;
+        }
+    }
+
+    // Ядро пишет результат поверх своего же аргумента
+    for (int b = 0; b < NUM_BUCKETS; b++) {
+        const int k = b < FIRST_K_BUCKET ? 0 : b - FIRST_K_BUCKET + 1;
+        kernel(reduced + offsets[b], offsets[b + 1] - offsets[b], k, ldexp(eps, -k), reduced + offsets[b]);
+    }
+    for (size_t position = 0; position < offsets[NUM_BUCKETS]; position++) {
+        results[order[position]] = reduced[position];
+    }
+}
+
+// Сумма ряда для массива точек: плитки по SERIES_TILE точек
+void series_sum_batch(const double* points, size_t n, double eps, double* results) {
+    for (size_t begin = 0; begin < n; begin += SERIES_TILE) {
+        series_sum_tile(points + begin, min(SERIES_TILE, n - begin), eps, results + begin);
+    }
+}
+
+std::vector<double> series_sum_batch(const std::vector<double>& points, double eps) {
+    std::vector<double> results(points.size());
+    series_sum_batch(points.data(), points.size(), eps, results.data());
+    return results;
+}
+
+// Движок рядов Тейлора. Ряд задаётся рекуррентным отношением соседних членов:
+//   f(x) = first(x) * sum_n a_n z^n,  z = argument(x),  a_0 = 1,  a_{n+1} = a_n * ratio(n),
+// где ratio(n) > 0 — constexpr функция номера члена. Перед суммированием аргумент
+// приводится функцией reduce (для sin и cos — в [-pi, pi]).
+//
+// На области |reduce(x)| <= domain число членов, достаточное для точности eps, оценивается
+// заранее (fixed_terms), и ряд считается ядром series_fixed<S, Terms> — схемой Горнера по
+// коэффициентам a_n, вычисленным при компиляции, без проверки сходимости. Вне области, а
+// также если членов нужно больше MAX_FIXED_TERMS, работает адаптивное суммирование
+// series_adaptive — тот же цикл, что в series_reduced, пока член больше eps.
+
+const int FIXED_TERMS_STEP = 4; // Ядра есть для числа членов, кратного шагу
+const int MAX_FIXED_TERMS = 64;
+
+template <typename S>
+double series_adaptive(double x, double eps, long long* terms = nullptr); // Адаптивная сумма ряда S
+template <typename S>
+double series_adaptive_reduced(double x, double eps, long long* terms); // То же по уже приведённому x
+
+// exp(-x^2) = sum (-x^2)^n / n!; вне области работает series_sum с возведением в квадрат
+struct ExpMinusSquareSeries {
+    static constexpr double domain = 1.0;
+    static constexpr double radius = numeric_limits<double>::infinity(); // Радиус сходимости по reduce(x)
+    static constexpr double ratio_limit = 0.0; // Предел ratio(n) при n -> inf
+    static double reduce(double x) { return x; }
+    static constexpr double first(double) { return 1.0; }
+    static constexpr double first_bound() { return 1.0; } // max |first(x)| на области
+    static constexpr double argument(double x) { return -x * x; }
+    static constexpr double ratio(int n) { return 1.0 / (n + 1); }
+    static double adaptive(double x, double eps, long long* terms) { return series_sum(x, eps, terms); }
+};
+
+// sin x = sum (-1)^n x^(2n+1) / (2n+1)!
+struct SinSeries {
+    static constexpr double PI = 3.14159265358979323846;
+    static constexpr double domain = PI;
+    static constexpr double radius = numeric_limits<double>::infinity();
+    static constexpr double ratio_limit = 0.0;
+    static double reduce(double x) { return fabs(x) <= PI ? x : remainder(x, 2.0 * PI); }
+    static constexpr double first(double x) { return x; }
+    static constexpr double first_bound() { return domain; }
+    static constexpr double argument(double x) { return -x * x; }
+    static constexpr double ratio(int n) { return 1.0 / ((2.0 * n + 2.0) * (2.0 * n + 3.0)); }
+};
+
+// cos x = sum (-1)^n x^(2n) / (2n)!
+struct CosSeries {
+    static constexpr double domain = SinSeries::PI;
+    static constexpr double radius = numeric_limits<double>::infinity();
+    static constexpr double ratio_limit = 0.0;
+    static double reduce(double x) { return SinSeries::reduce(x); }
+    static constexpr double first(double) { return 1.0; }
+    static constexpr double first_bound() { return 1.0; }
+    static constexpr double argument(double x) { return -x * x; }
+    static constexpr double ratio(int n) { return 1.0 / ((2.0 * n + 1.0) * (2.0 * n + 2.0)); }
+};
+
+// erf x = 2 / sqrt(pi) * exp(-x^2) * sum (2x^2)^n x / (1 * 3 * ... * (2n+1)): члены
+// положительны и не сокращаются, поэтому ряд точен и там, где знакопеременный теряет точность
+struct ErfPositiveSeries {
+    static constexpr double TWO_OVER_SQRT_PI = 1.12837916709551257390;
+    static constexpr double radius = numeric_limits<double>::infinity();
+    static constexpr double ratio_limit = 0.0;
+    static double reduce(double x) { return x; }
+    static double first(double x) { return TWO_OVER_SQRT_PI * x * exp(-x * x); }
+    static constexpr double argument(double x) { return 2.0 * x * x; }
+    static constexpr double ratio(int n) { return 1.0 / (2.0 * n + 3.0); }
+};
+
+// erf x = 2 / sqrt(pi) * sum (-1)^n x^(2n+1) / (n! (2n+1)); при |x| <= domain адаптивный ряд
+// тот же, вне области знакопеременные члены растут, и работает ErfPositiveSeries,
+// а при |x| > 6 erf x = +-1 с точностью double (erfc 6 < 2.2e-17)
+struct ErfSeries {
+    static constexpr double TWO_OVER_SQRT_PI = 1.12837916709551257390;
+    static constexpr double domain = 2.0;
+    static constexpr double radius = numeric_limits<double>::infinity();
+    static constexpr double ratio_limit = 0.0;
+    static double reduce(double x) { return x; }
+    static constexpr double first(double x) { return TWO_OVER_SQRT_PI * x; }
+    static constexpr double first_bound() { return TWO_OVER_SQRT_PI * domain; }
+    static constexpr double argument(double x) { return -x * x; }
+    static constexpr double ratio(int n) { return (2.0 * n + 1.0) / ((n + 1.0) * (2.0 * n + 3.0)); }
+    static double adaptive(double x, double eps, long long* terms) {
+        if (fabs(x) <= domain) {
+            return series_adaptive_reduced<ErfSeries>(x, eps, terms);
+        }
+        return fabs(x) > 6.0 ? copysign(1.0, x) : series_adaptive<ErfPositiveSeries>(x, eps, terms);
+    }
+};
+
+// log(1 + x) = 2 atanh u = 2 * sum u^(2n+1) / (2n+1), где u = x / (2 + x): |u| < 1 при
+// любом x > -1. Вне области 1 + x = m * 2^e, m в [0.5, 1), и log(1 + x) = e log 2 + log m,
+// так что ряд считается при |u| <= 1/3; 1 + x здесь точно (x < -0.5) или теряет лишь
+// биты, меньшие относительной точности результата (x > 2)
+struct Log1pSeries {
+    static constexpr double LN2 = 0.69314718055994530942;
+    static constexpr double domain = 0.5; // По u: x в [-2/3, 2]
+    static constexpr double radius = 1.0;
+    static constexpr double ratio_limit = 1.0;
+    static double reduce(double x) { return x / (2.0 + x); }
+    static constexpr double first(double u) { return 2.0 * u; }
+    static constexpr double first_bound() { return 2.0 * domain; }
+    static constexpr double argument(double u) { return u * u; }
+    static constexpr double ratio(int n) { return (2.0 * n + 1.0) / (2.0 * n + 3.0); }
+    static double adaptive(double x, double eps, long long* terms) {
+        if (isnan(x) || x < -1.0) {
+            return numeric_limits<double>::quiet_NaN();
+        }
+        if (x == -1.0 || isinf(x)) {
+            return x == -1.0 ? -numeric_limits<double>::infinity() : x;
+        }
+        if (fabs(reduce(x)) <= domain) {
+            return series_adaptive_reduced<Log1pSeries>(reduce(x), eps, terms);
+        }
+        int e;
+        const double m = frexp(1.0 + x, &e);
+        return e * LN2 + series_adaptive_reduced<Log1pSeries>((m - 1.0) / (m + 1.0), eps, terms);
+    }
+};
+
+// Наименьшее число членов, при котором отброшенный хвост на всей области не больше eps,
+// или MAX_FIXED_TERMS + 1, если столько членов не хватает. Член n не больше
+// first_bound * |z|max^n * a_n, а хвост после него — геометрической прогрессии со
+// знаменателем q = |z|max * max(ratio(n), ratio_limit) (ratio монотонно стремится к пределу).
+template <typename S>
+constexpr int fixed_terms(double eps) {
+    const double z_max = S::argument(S::domain) < 0 ? -S::argument(S::domain) : S::argument(S::domain);
+    double term_bound = S::first_bound();
+    for (int n = 0; n <= MAX_FIXED_TERMS; n++) {
+        const double q = z_max * max(S::ratio(n), S::ratio_limit);
+        if (q < 1.0 && term_bound / (1.0 - q) <= eps) {
+            return n;
+        }
+        term_bound *= z_max * S::ratio(n);
+    }
+    return MAX_FIXED_TERMS + 1;
+}
+
+// Все функции получают ядро с фиксированным числом членов вплоть до точности double
+static_assert(fixed_terms<ExpMinusSquareSeries>(1e-16) <= MAX_FIXED_TERMS);
+static_assert(fixed_terms<SinSeries>(1e-16) <= MAX_FIXED_TERMS);
+static_assert(fixed_terms<CosSeries>(1e-16) <= MAX_FIXED_TERMS);
+static_assert(fixed_terms<ErfSeries>(1e-16) <= MAX_FIXED_TERMS);
+static_assert(fixed_terms<Log1pSeries>(1e-16) <= MAX_FIXED_TERMS);
+
+// Коэффициенты a_0 .. a_{Terms-1}, вычисленные при компиляции
+template <typename S, int Terms>
+constexpr array<double, Terms> series_coefficients() {
+    array<double, Terms> a{};
+    a[0] = 1.0;
+    for (int n = 1; n < Terms; n++) {
+        a[n] = a[n - 1] * S::ratio(n - 1);
+    }
+    return a;
+}
+
+// Ядро с фиксированным числом членов для уже приведённых аргументов из области.
+// Схема Горнера раскручивается полностью, ветвлений внутри точки нет.
+using SeriesFixedKernel = void (*)(const double* x, size_t count, double* out);
+
+template <typename S, int Terms>
+void series_fixed(const double* x, size_t count, double* out) {
+    static constexpr array<double, Terms> a = series_coefficients<S, Terms>();
+    for (size_t i = 0; i < count; i++) {
+        const double z = S::argument(x[i]);
+        double sum = a[Terms - 1];
+#pragma GCC unroll 64
+        for (int n = Terms - 2; n >= 0; n--) {
+            sum = sum * z + a[n];
+        }
+        out[i] = S::first(x[i]) * sum;
+    }
+}
+
+// Ядра для FIXED_TERMS_STEP, 2 * FIXED_TERMS_STEP, ..., MAX_FIXED_TERMS членов
+template <typename S, size_t... I>
+constexpr array<SeriesFixedKernel, sizeof...(I)> series_fixed_kernels(index_sequence<I...>) {
+    return { series_fixed<S, (int)(I + 1) * FIXED_TERMS_STEP>... };
+}
+
+// Ядро для точности eps или nullptr, если членов нужно больше MAX_FIXED_TERMS
+template <typename S>
+SeriesFixedKernel select_fixed_kernel(double eps, int* terms = nullptr) {
+    static constexpr auto kernels =
+        series_fixed_kernels<S>(make_index_sequence<MAX_FIXED_TERMS / FIXED_TERMS_STEP>());
+    const int needed = fixed_terms<S>(eps);
+    if (needed > MAX_FIXED_TERMS) {
+        return nullptr;
+    }
+    const int index = max(1, (needed + FIXED_TERMS_STEP - 1) / FIXED_TERMS_STEP) - 1;
+    if (terms != nullptr) {
+        *terms = (index + 1) * FIXED_TERMS_STEP;
+    }
+    return kernels[index];
+}
+
+// Адаптивная сумма ряда: члены добавляются с компенсацией Ноймайера, пока хвост после
+// текущего члена (та же оценка прогрессией, что в fixed_terms) больше eps.
+// Вне радиуса сходимости ряд расходится, и результат — NaN.
+template <typename S>
+double series_adaptive(double x, double eps, long long* terms) {
+    if constexpr (requires { S::adaptive(x, eps, terms); }) {
+        return S::adaptive(x, eps, terms);
+    }
+    else {
+        return series_adaptive_reduced<S>(S::reduce(x), eps, terms);
+    }
+}
+
+// Цикл адаптивного суммирования по приведённому аргументу, без S::adaptive: им
+// пользуются и сами ряды, которым нужна своя обработка части аргументов
+template <typename S>
+double series_adaptive_reduced(double x, double eps, long long* terms) {
+    if (!(fabs(x) < S::radius)) {
+        return numeric_limits<double>::quiet_NaN();
+    }
+    const double z = S::argument(x);
+    double sum = 0.0; // Сумма ряда
+    double compensation = 0.0; // Накопленная ошибка округления суммы
+    double term = S::first(x); // Текущий член ряда
+    int n = 0; // Номер члена ряда
+    for (;;) {
+        const double q = fabs(z) * max(S::ratio(n), S::ratio_limit);
+        if (q < 1.0 && fabs(term) <= eps * (1.0 - q)) {
+            break;
+        }
+        const double t = sum + term;
+        if (fabs(sum) >= fabs(term)) {
+            compensation += (sum - t) + term;
+        }
+        else {
+            compensation += (term - t) + sum;
+        }
+        sum = t;
+        term *= z * S::ratio(n); // Следующий член ряда из предыдущего
+        n++;
+    }
+    if (terms != nullptr) {
+        *terms += n;
+    }
+    return sum + compensation;
+}
+
+// Ряд для массива точек: подряд идущие точки области (не больше SERIES_TILE) считаются
+// ядром с фиксированным числом членов, остальные — адаптивно
+template <typename S>
+void series_batch(const double* points, size_t n, double eps, double* results) {
+    const SeriesFixedKernel kernel = select_fixed_kernel<S>(eps);
+    double reduced[SERIES_TILE];
+    for (size_t i = 0; i < n;) {
+        size_t run = 0;
+        while (kernel != nullptr && run < SERIES_TILE && i + run < n) {
+            const double x = S::reduce(points[i + run]);
+            if (!(fabs(x) <= S::domain)) {
+                break;
+            }
+            reduced[run++] = x;
+        }
+        if (run > 0) {
+            kernel(reduced, run, results + i);
+            i += run;
+        }
+        else {
+            results[i] = series_adaptive<S>(points[i], eps);
+            i++;
+        }
+    }
+}
+
+double exp_minus_square(double x) {
+    return exp(-x * x);
+}
+
+// exp(-x^2) считается прежним пакетным путём series_sum_batch (SIMD-полосы и уменьшение
+// аргумента), остальные функции — движком
+const SeriesFunctionInfo SERIES_FUNCTIONS[] = {
+    { "exp", "exp(-x^2)", exp_minus_square, series_sum_batch },
+    { "sin", "sin(x)", [](double x) { return sin(x); }, series_batch<SinSeries> },
+    { "cos", "cos(x)", [](double x) { return cos(x); }, series_batch<CosSeries> },
+    { "erf", "erf(x)", [](double x) { return erf(x); }, series_batch<ErfSeries> },
+    { "log1p", "log1p(x)", [](double x) { return log1p(x); }, series_batch<Log1pSeries> },
+};
+
+const SeriesFunctionInfo* find_series_function(string_view name) {
+    for (const SeriesFunctionInfo& function : SERIES_FUNCTIONS) {
+        if (name == function.option) {
+            return &function;
+        }
+    }
+    return nullptr;
+}
+
+void bench_series(const Options& opts) {
+    const long long n = opts.bench_points;
+    const double step = 2.0 * opts.bench_range / static_cast<double>(max(1LL, n - 1));
+
+    // Прогон на всей сетке: число членов, время и ошибка относительно exp(-x*x)
+    long long terms = 0;
+    double checksum = 0.0;
+    const double start = MPI_Wtime();
+    for (long long i = 0; i < n; i++) {
+        checksum += series_sum(-opts.bench_range + i * step, opts.eps, &terms);
+    }
+    const double elapsed = MPI_Wtime() - start;
+
+    double max_abs_error = 0.0; // Максимальная абсолютная ошибка
+    double max_rel_error = 0.0; // Максимальная относительная ошибка (где exp(-x^2) >= DBL_MIN)
+    for (long long i = 0; i < n; i++) {
+        const double x = -opts.bench_range + i * step;
+        const double exact = exp(-x * x);
+        const double error = fabs(series_sum(x, opts.eps) - exact);
+        max_abs_error = max(max_abs_error, error);
+        if (exact >= numeric_limits<double>::min()) {
+            max_rel_error = max(max_rel_error, error / exact);
+        }
+    }
+
+    cout << "points: " << n << ", range: [" << -opts.bench_range << ", " << opts.bench_range
+        << "], eps: " << opts.eps << "\n";
+    cout << "time: " << elapsed << " s, points/s: " << n / elapsed << ", terms/s: " << terms / elapsed
+        << ", terms/point: " << static_cast<double>(terms) / n << "\n";
+    cout << "max |sum - exp(-x^2)|: " << max_abs_error << ", max relative error: " << max_rel_error
+        << " (checksum " << checksum << ")" << endl;
+
+    // Пакетная SIMD-версия на той же сетке
+    std::vector<double> points(n);
+    for (long long i = 0; i < n; i++) {
+        points[i] = -opts.bench_range + i * step;
+    }
+    const double batch_start = MPI_Wtime();
+    const std::vector<double> batch = series_sum_batch(points, opts.eps);
+    const double batch_elapsed = MPI_Wtime() - batch_start;
+
+    double max_batch_diff = 0.0; // Расхождение пакетной и скалярной версий
+    for (long long i = 0; i < n; i++) {
+        max_batch_diff = max(max_batch_diff, fabs(batch[i] - series_sum(points[i], opts.eps)));
+    }
+    cout << "batch time: " << batch_elapsed << " s, points/s: " << n / batch_elapsed << ", speedup: "
+        << elapsed / batch_elapsed << ", max |batch - scalar|: " << max_batch_diff << endl;
+}
+
+// Бенчмарк одной функции движка на сетке из opts.bench_points точек её области
+template <typename S>
+void bench_engine_function(const char* label, double (*exact)(double), const Options& opts) {
+    const long long n = opts.bench_points;
+    const double step = 2.0 * S::domain / static_cast<double>(max(1LL, n - 1));
+    std::vector<double> points(n), fixed(n), adaptive(n);
+    for (long long i = 0; i < n; i++) {
+        points[i] = -S::domain + i * step;
+    }
+
+    int fixed_count = 0;
+    const bool has_kernel = select_fixed_kernel<S>(opts.eps, &fixed_count) != nullptr;
+    const double fixed_start = MPI_Wtime();
+    series_batch<S>(points.data(), points.size(), opts.eps, fixed.data());
+    const double fixed_elapsed = MPI_Wtime() - fixed_start;
+
+    long long terms = 0;
+    const double adaptive_start = MPI_Wtime();
+    for (long long i = 0; i < n; i++) {
+        adaptive[i] = series_adaptive<S>(points[i], opts.eps, &terms);
+    }
+    const double adaptive_elapsed = MPI_Wtime() - adaptive_start;
+
+    double fixed_error = 0.0, adaptive_error = 0.0;
+    for (long long i = 0; i < n; i++) {
+        fixed_error = accumulate_error(fixed_error, fixed[i], exact(points[i]));
+        adaptive_error = accumulate_error(adaptive_error, adaptive[i], exact(points[i]));
+    }
+    cout << label << "," << S::domain << "," << (has_kernel ? fixed_count : 0) << ","
+        << static_cast<double>(terms) / n << "," << n / fixed_elapsed << "," << n / adaptive_elapsed << ","
+        << adaptive_elapsed / fixed_elapsed << "," << fixed_error << "," << adaptive_error << "\n";
+}
+
+// Ядра с фиксированным числом членов против адаптивного суммирования на области каждой функции.
+// Без ядра для opts.eps (членов нужно больше MAX_FIXED_TERMS) обе колонки — адаптивный ряд.
+void bench_engine(const Options& opts) {
+    cout << "points: " << opts.bench_points << ", eps: " << opts.eps << "\n";
+    cout << "function,domain,fixed_terms,adaptive_terms,fixed_points/s,adaptive_points/s,speedup,"
+        << "max_error_fixed,max_error_adaptive\n";
+    bench_engine_function<ExpMinusSquareSeries>("exp(-x^2)", find_series_function("exp")->exact, opts);
+    bench_engine_function<SinSeries>("sin(x)", find_series_function("sin")->exact, opts);
+    bench_engine_function<CosSeries>("cos(x)", find_series_function("cos")->exact, opts);
+    bench_engine_function<ErfSeries>("erf(x)", find_series_function("erf")->exact, opts);
+    bench_engine_function<Log1pSeries>("log1p(x)", find_series_function("log1p")->exact, opts);
+    cout << flush;
+}
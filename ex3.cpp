@@ -2,22 +2,61 @@
 #include <mpi.h>
 #include <vector>
 #include <cstdlib>
-#include <ctime>
+#include <climits>
+#include <cstdint>
+#include <array>
+#include <span>
+#include <concepts>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <algorithm>
+#include <bit>
+#include "reduce_ops.h"
+#include "phase_timer.h"
 
 using namespace std;
 
 const int MASTER_RANK = 0;
 
-inline void master_process(int num_processes, int n);
-inline void slave_process(int rank, int n);
-inline void min_fibonacci_opFunc(int* in, int* inout, int* len, MPI_Datatype* dtype);
-inline int find_min_fibonacci_greater_than(int num);
+using reduce_ops::find_min_fibonacci_greater_than;
+
+// Способ получить результат на процессах
+enum class AllreduceMode {
+    None, // Результат только на MASTER_RANK (MPI_Ireduce)
+    Library, // Библиотечный MPI_Iallreduce
+    RecursiveDoubling, // Рекурсивное удвоение поверх пользовательской операции
+    Rabenseifner // Reduce-scatter рекурсивным делением пополам + allgather рекурсивным удвоением
+};
+
+// Параметры запуска, полученные из командной строки
+struct Options {
+    long long n = 5; // Количество элементов на каждом процессе
+    int segment = 1 << 20; // Элементов в одном сегменте конвейерной редукции
+    uint64_t seed = 0; // Зерно счётчикового генератора: один seed — одни и те же данные
+    bool bench_fibonacci = false; // Бенчмарк поиска чисел Фибоначчи
+    bool bench_ops = false; // Бенчмарк операций reduce_ops против встроенных MPI_MIN/MPI_MINLOC
+    long long max_length = 100000000; // Наибольшая длина вектора в бенчмарках операций и allreduce
+    AllreduceMode allreduce = AllreduceMode::None; // Результат нужен на всех процессах
+    bool bench_allreduce = false; // Бенчмарк allreduce: библиотечный против рукописных
+    bool phases = false; // Печать длительности фаз для bench_driver
+};
+
+const long long PRINT_LIMIT = 32; // Данные выводятся поэлементно только для малых n
+const int SEGMENTS_IN_FLIGHT = 2; // Сегментов, редукция которых идёт одновременно с генерацией
+const int TAG_ALLREDUCE = 1; // Тег сообщений рукописных allreduce
+
+inline Options parse_options(int argc, char** argv);
+inline void master_process(const Options& opts);
+inline void slave_process(int rank, const Options& opts);
+inline void allreduce_process(int rank, const Options& opts);
+inline void bench_fibonacci();
+inline void bench_ops(int rank, const Options& opts);
+inline void bench_allreduce(int rank, int num_processes, const Options& opts);
 
 int main(int argc, char** argv) {
     // Инициализация переменных для хранения ранга и количества процессов
     int rank, num_processes;
-    // Количество элементов для обработки
-    int n = 5;
 
     // Инициализация MPI
     MPI_Init(&argc, &argv);
@@ -26,6 +65,31 @@ int main(int argc, char** argv) {
     // Получение общего количества процессов
     MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
 
+    const Options opts = parse_options(argc, argv);
+
+    // Бенчмарк поиска чисел Фибоначчи выполняется только на master-процессе
+    if (opts.bench_fibonacci) {
+        if (rank == MASTER_RANK) {
+            bench_fibonacci();
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Бенчмарк операций редукции выполняется всеми процессами
+    if (opts.bench_ops) {
+        bench_ops(rank, opts);
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Бенчмарк allreduce выполняется всеми процессами
+    if (opts.bench_allreduce) {
+        bench_allreduce(rank, num_processes, opts);
+        MPI_Finalize();
+        return 0;
+    }
+
     // Проверка, что количество процессов не меньше двух
     if (num_processes < 2) {
         if (rank == MASTER_RANK) {
@@ -35,13 +99,17 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    // Результат нужен на всех процессах: все процессы симметричны
+    if (opts.allreduce != AllreduceMode::None) {
+        allreduce_process(rank, opts);
+    }
     // Запуск master-процесса
-    if (rank == MASTER_RANK) {
-        master_process(num_processes, n);
+    else if (rank == MASTER_RANK) {
+        master_process(opts);
     }
     // Запуск slave-процессов
     else {
-        slave_process(rank, n);
+        slave_process(rank, opts);
     }
 
     // Завершение работы MPI
@@ -49,77 +117,569 @@ int main(int argc, char** argv) {
     return 0;
 }
 
-// Функция для master-процесса
-void master_process(int num_processes, int n) {
-    // Инициализация результата большим значением
-    vector<int> result(n, INT_MAX);
+// Разбор аргументов вида --n=N --segment=S --seed=X --allreduce[=library|doubling|rabenseifner]
+// --bench-fibonacci --bench-ops --bench-allreduce --max-length=L --phases
+Options parse_options(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--bench-fibonacci") {
+            opts.bench_fibonacci = true;
+        }
+        else if (arg == "--bench-ops") {
+            opts.bench_ops = true;
+        }
+        else if (arg == "--bench-allreduce") {
+            opts.bench_allreduce = true;
+        }
+        else if (arg == "--allreduce" || arg == "--allreduce=library") {
+            opts.allreduce = AllreduceMode::Library;
+        }
+        else if (arg == "--allreduce=doubling") {
+            opts.allreduce = AllreduceMode::RecursiveDoubling;
+        }
+        else if (arg == "--allreduce=rabenseifner") {
+            opts.allreduce = AllreduceMode::Rabenseifner;
+        }
+        else if (arg == "--phases") {
+            opts.phases = true;
+        }
+        else if (arg.starts_with("--max-length=")) {
+            opts.max_length = max(1LL, strtoll(argv[i] + 13, nullptr, 10));
+        }
+        else if (arg.starts_with("--n=")) {
+            opts.n = strtoll(argv[i] + 4, nullptr, 10);
+        }
+        else if (arg.starts_with("--segment=")) {
+            opts.segment = max(1, atoi(argv[i] + 10));
+        }
+        else if (arg.starts_with("--seed=")) {
+            opts.seed = strtoull(argv[i] + 7, nullptr, 10);
+        }
+    }
+    return opts;
+}
 
-    // Создание пользовательской операции для нахождения минимального числа Фибоначчи
-    MPI_Op min_fibonacci_op;
-    MPI_Op_create((MPI_User_function*)min_fibonacci_opFunc, 1, &min_fibonacci_op);
+// Счётчиковый генератор: число зависит только от (seed, rank, index), без общего состояния
+uint64_t counter_random(uint64_t seed, uint64_t rank, uint64_t index) {
+    auto mix = [](uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    };
+    return mix(mix(seed ^ (rank * 0x9E3779B97F4A7C15ull)) + index * 0x9E3779B97F4A7C15ull);
+}
 
-    // Сбор результатов от всех процессов
-    MPI_Reduce(MPI_IN_PLACE, result.data(), n, MPI_INT, min_fibonacci_op, MASTER_RANK, MPI_COMM_WORLD);
+// Случайное число процесса rank с номером index в диапазоне [-50, 50]
+int generate_value(const Options& opts, int rank, long long index) {
+    return static_cast<int>(counter_random(opts.seed, rank, index) % 101) - 50;
+}
 
-    // Вывод результата
-    cout << "Result: ";
-    for (int i = 0; i < n; ++i) {
-        cout << result[i] << " ";
+// Генерация сегмента [offset, offset + count). Пока сегмент генерируется, в фоне идёт
+// редукция предыдущих сегментов; периодический MPI_Test даёт ей продвигаться.
+void generate_segment(const Options& opts, int rank, long long offset, int count, int* values,
+    MPI_Request* in_flight) {
+    const int TEST_INTERVAL = 1 << 16;
+    for (int begin = 0; begin < count; begin += TEST_INTERVAL) {
+        const int end = min(count, begin + TEST_INTERVAL);
+        for (int i = begin; i < end; ++i) {
+            values[i] = generate_value(opts, rank, offset + i);
+        }
+        for (int slot = 0; slot < SEGMENTS_IN_FLIGHT; ++slot) {
+            int done;
+            MPI_Test(&in_flight[slot], &done, MPI_STATUS_IGNORE);
+        }
+    }
+}
+
+// Вывод сгенерированных чисел и результатов (только для малых n)
+void print_generated(const Options& opts, int rank) {
+    cout << "Process " << rank << " generated numbers: ";
+    for (long long i = 0; i < opts.n; ++i) {
+        cout << generate_value(opts, rank, i) << " ";
+    }
+    cout << "\nProcess " << rank << " Fibonacci results: ";
+    for (long long i = 0; i < opts.n; ++i) {
+        cout << find_min_fibonacci_greater_than(generate_value(opts, rank, i)) << " ";
     }
     cout << endl;
+}
+
+// Итог редукции: поэлементный результат (только для малых n), минимум и контрольная сумма
+struct ResultSummary {
+    vector<int> values;
+    int min = INT_MAX;
+    long long checksum = 0;
+
+    // Сворачивание редуцированного сегмента: поиск чисел Фибоначчи и добавление в итог
+    void consume(const Options& opts, span<int> segment) {
+        reduce_ops::finalize_min_fibonacci(segment);
+        for (int value : segment) {
+            min = std::min(min, value);
+            checksum += value;
+        }
+        if (opts.n <= PRINT_LIMIT) {
+            values.insert(values.end(), segment.begin(), segment.end());
+        }
+    }
+
+    void print(const Options& opts, double elapsed) const {
+        if (opts.n <= PRINT_LIMIT) {
+            cout << "Result: ";
+            for (int value : values) {
+                cout << value << " ";
+            }
+            cout << endl;
+        }
+        else {
+            cout << "Result: " << opts.n << " elements, min " << min << ", checksum " << checksum << endl;
+        }
+        cout << "Time: " << elapsed << " s (" << opts.n / elapsed / 1e6 << " M elements/s per process)" << endl;
+    }
+};
+
+// Функция для master-процесса. Master тоже генерирует свою часть данных и редуцирует
+// сегменты на месте (MPI_IN_PLACE). Операция Op::MinFibonacci сворачивает исходные значения,
+// а числа Фибоначчи ищутся один раз для редуцированного сегмента. Готовые сегменты сразу
+// сворачиваются в итог, поэтому память ограничена SEGMENTS_IN_FLIGHT сегментами при любом n.
+void master_process(const Options& opts) {
+    const MPI_Op min_fibonacci_op = reduce_ops::get(reduce_ops::Op::MinFibonacci);
+
+    const long long num_segments = (opts.n + opts.segment - 1) / opts.segment;
+    vector<vector<int>> buffers(SEGMENTS_IN_FLIGHT, vector<int>(min<long long>(opts.segment, opts.n)));
+    MPI_Request requests[SEGMENTS_IN_FLIGHT] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
 
-    // Освобождение пользовательской операции
-    MPI_Op_free(&min_fibonacci_op);
+    ResultSummary result;
+    auto consume = [&](int slot, long long segment) {
+        const int count = (int)min<long long>(opts.segment, opts.n - segment * opts.segment);
+        result.consume(opts, span<int>(buffers[slot].data(), count));
+    };
+
+    if (opts.n <= PRINT_LIMIT) {
+        print_generated(opts, MASTER_RANK);
+    }
+
+    const double start = MPI_Wtime();
+    for (long long segment = 0; segment < num_segments; ++segment) {
+        const int slot = (int)(segment % SEGMENTS_IN_FLIGHT);
+        if (segment >= SEGMENTS_IN_FLIGHT) {
+            MPI_Wait(&requests[slot], MPI_STATUS_IGNORE);
+            consume(slot, segment - SEGMENTS_IN_FLIGHT);
+        }
+
+        const int count = (int)min<long long>(opts.segment, opts.n - segment * opts.segment);
+        generate_segment(opts, MASTER_RANK, segment * opts.segment, count, buffers[slot].data(), requests);
+        MPI_Ireduce(MPI_IN_PLACE, buffers[slot].data(), count, MPI_INT, min_fibonacci_op, MASTER_RANK,
+            MPI_COMM_WORLD, &requests[slot]);
+    }
+    for (long long segment = max(0LL, num_segments - SEGMENTS_IN_FLIGHT); segment < num_segments; ++segment) {
+        const int slot = (int)(segment % SEGMENTS_IN_FLIGHT);
+        MPI_Wait(&requests[slot], MPI_STATUS_IGNORE);
+        consume(slot, segment);
+    }
+    const double elapsed = MPI_Wtime() - start;
+
+    // Вывод результата
+    result.print(opts, elapsed);
 }
 
-// Функция для slave-процессов
-void slave_process(int rank, int n) {
-    // Инициализация генератора случайных чисел
-    srand((int)time(0) + rank);
+// Функция для slave-процессов: генерация сегментами и конвейерная редукция той же операцией
+void slave_process(int rank, const Options& opts) {
+    const MPI_Op min_fibonacci_op = reduce_ops::get(reduce_ops::Op::MinFibonacci);
 
-    // Генерация случайных чисел
-    vector<int> data(n);
-    for (int i = 0; i < n; ++i) {
-        data[i] = rand() % 101 - 50;
+    if (opts.n <= PRINT_LIMIT) {
+        print_generated(opts, rank);
     }
 
-    // Нахождение минимального числа Фибоначчи для каждого элемента
-    vector<int> fibonacci_results(n);
-    for (int i = 0; i < n; ++i) {
-        fibonacci_results[i] = find_min_fibonacci_greater_than(data[i]);
+    const long long num_segments = (opts.n + opts.segment - 1) / opts.segment;
+    vector<vector<int>> buffers(SEGMENTS_IN_FLIGHT, vector<int>(min<long long>(opts.segment, opts.n)));
+    MPI_Request requests[SEGMENTS_IN_FLIGHT] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    for (long long segment = 0; segment < num_segments; ++segment) {
+        const int slot = (int)(segment % SEGMENTS_IN_FLIGHT);
+        // Буфер можно переиспользовать только после завершения его редукции
+        MPI_Wait(&requests[slot], MPI_STATUS_IGNORE);
+
+        const int count = (int)min<long long>(opts.segment, opts.n - segment * opts.segment);
+        generate_segment(opts, rank, segment * opts.segment, count, buffers[slot].data(), requests);
+
+        // Отправка результатов master-процессу
+        MPI_Ireduce(buffers[slot].data(), nullptr, count, MPI_INT, min_fibonacci_op, MASTER_RANK, MPI_COMM_WORLD,
+            &requests[slot]);
     }
+    MPI_Waitall(SEGMENTS_IN_FLIGHT, requests, MPI_STATUSES_IGNORE);
+}
 
-    // Вывод сгенерированных чисел и результатов
-    cout << "Process " << rank << " generated numbers: ";
-    for (int i = 0; i < n; ++i) {
-        cout << data[i] << " ";
+// Ранг в comm процесса с номером new_rank среди pof2 участников основной фазы. При числе
+// процессов, не равном степени двойки, первые 2 * rem процессов попарно сливаются в нечётные.
+int allreduce_real_rank(int new_rank, int rem) {
+    return new_rank < rem ? new_rank * 2 + 1 : new_rank + rem;
+}
+
+// Подготовка к основной фазе: чётные процессы из первых 2 * rem отдают данные соседу и
+// выбывают. Возвращает номер процесса среди pof2 участников или -1 для выбывших.
+template <typename T>
+int allreduce_fold_in(T* buffer, T* temp, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm, int rank,
+    int rem) {
+    if (rank >= 2 * rem) {
+        return rank - rem;
     }
-    cout << "\nProcess " << rank << " Fibonacci results: ";
-    for (int i = 0; i < n; ++i) {
-        cout << fibonacci_results[i] << " ";
+    if (rank % 2 == 0) {
+        MPI_Send(buffer, count, type, rank + 1, TAG_ALLREDUCE, comm);
+        return -1;
     }
-    cout << endl;
+    MPI_Recv(temp, count, type, rank - 1, TAG_ALLREDUCE, comm, MPI_STATUS_IGNORE);
+    MPI_Reduce_local(temp, buffer, count, type, op);
+    return rank / 2;
+}
 
-    // Отправка результатов master-процессу
-    MPI_Reduce(fibonacci_results.data(), nullptr, n, MPI_INT, MPI_MIN, MASTER_RANK, MPI_COMM_WORLD);
+// Возврат результата выбывшим процессам
+template <typename T>
+void allreduce_fold_out(T* buffer, int count, MPI_Datatype type, MPI_Comm comm, int rank, int rem) {
+    if (rank < 2 * rem) {
+        if (rank % 2 == 1) {
+            MPI_Send(buffer, count, type, rank - 1, TAG_ALLREDUCE, comm);
+        }
+        else {
+            MPI_Recv(buffer, count, type, rank + 1, TAG_ALLREDUCE, comm, MPI_STATUS_IGNORE);
+        }
+    }
+}
+
+// Allreduce рекурсивным удвоением: log2(p) шагов обмена целым вектором. Выгоден для
+// коротких векторов, где время определяется латентностью. Операция должна быть коммутативной.
+template <typename T>
+void allreduce_recursive_doubling(T* buffer, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    const int pof2 = bit_floor(static_cast<unsigned>(size));
+    const int rem = size - pof2;
+
+    vector<T> temp(count);
+    const int new_rank = allreduce_fold_in(buffer, temp.data(), count, type, op, comm, rank, rem);
+    if (new_rank != -1) {
+        for (int mask = 1; mask < pof2; mask <<= 1) {
+            const int partner = allreduce_real_rank(new_rank ^ mask, rem);
+            MPI_Sendrecv(buffer, count, type, partner, TAG_ALLREDUCE, temp.data(), count, type, partner, TAG_ALLREDUCE,
+                comm, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(temp.data(), buffer, count, type, op);
+        }
+    }
+    allreduce_fold_out(buffer, count, type, comm, rank, rem);
+}
+
+// Allreduce Рабензейфнера: reduce-scatter рекурсивным делением пополам, затем allgather
+// рекурсивным удвоением. Каждый процесс пересылает около 2 * count элементов вместо
+// count * log2(p), поэтому алгоритм выгоден для длинных векторов.
+template <typename T>
+void allreduce_rabenseifner(T* buffer, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    const int pof2 = bit_floor(static_cast<unsigned>(size));
+    const int rem = size - pof2;
+
+    vector<T> temp(count);
+    const int new_rank = allreduce_fold_in(buffer, temp.data(), count, type, op, comm, rank, rem);
+    if (new_rank != -1) {
+        // Вектор делится на pof2 блоков; блок i после reduce-scatter принадлежит процессу i
+        vector<int> offsets(pof2 + 1);
+        for (int i = 0; i < pof2; ++i) {
+            offsets[i + 1] = offsets[i] + count / pof2 + (i < count % pof2 ? 1 : 0);
+        }
+        auto length = [&](int first, int last) { return offsets[last] - offsets[first]; };
+
+        // Reduce-scatter: диапазон блоков [low, high) сужается вдвое на каждом шаге
+        int low = 0, high = pof2;
+        for (int mask = pof2 / 2; mask > 0; mask >>= 1) {
+            const int partner = allreduce_real_rank(new_rank ^ mask, rem);
+            const int middle = (low + high) / 2;
+            const bool keep_low = (new_rank & mask) == 0;
+            const int send_low = keep_low ? middle : low, send_high = keep_low ? high : middle;
+            const int keep_from = keep_low ? low : middle, keep_to = keep_low ? middle : high;
+            MPI_Sendrecv(buffer + offsets[send_low], length(send_low, send_high), type, partner, TAG_ALLREDUCE,
+                temp.data() + offsets[keep_from], length(keep_from, keep_to), type, partner, TAG_ALLREDUCE, comm,
+                MPI_STATUS_IGNORE);
+            MPI_Reduce_local(temp.data() + offsets[keep_from], buffer + offsets[keep_from], length(keep_from, keep_to),
+                type, op);
+            low = keep_from;
+            high = keep_to;
+        }
+
+        // Allgather: диапазон удваивается в обратном порядке
+        for (int mask = 1; mask < pof2; mask <<= 1) {
+            const int partner = allreduce_real_rank(new_rank ^ mask, rem);
+            const int width = high - low;
+            const int other_low = (new_rank & mask) == 0 ? high : low - width;
+            MPI_Sendrecv(buffer + offsets[low], length(low, high), type, partner, TAG_ALLREDUCE,
+                buffer + offsets[other_low], length(other_low, other_low + width), type, partner, TAG_ALLREDUCE,
+                comm, MPI_STATUS_IGNORE);
+            low = min(low, other_low);
+            high = low + 2 * width;
+        }
+    }
+    allreduce_fold_out(buffer, count, type, comm, rank, rem);
+}
+
+// Allreduce выбранным способом (блокирующий)
+template <typename T>
+void allreduce(AllreduceMode mode, T* buffer, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm) {
+    switch (mode) {
+    case AllreduceMode::RecursiveDoubling:
+        allreduce_recursive_doubling(buffer, count, type, op, comm);
+        break;
+    case AllreduceMode::Rabenseifner:
+        allreduce_rabenseifner(buffer, count, type, op, comm);
+        break;
+    default:
+        MPI_Allreduce(MPI_IN_PLACE, buffer, count, type, op, comm);
+        break;
+    }
 }
 
-// Пользовательская операция для нахождения минимального числа Фибоначчи
-void min_fibonacci_opFunc(int* in, int* inout, int* len, MPI_Datatype* dtype) {
-    for (int i = 0; i < *len; ++i) {
-        inout[i] = min(inout[i], in[i]);
+// Функция для всех процессов в режиме --allreduce: каждый процесс генерирует свою часть и
+// получает поэлементный результат целиком. Библиотечный MPI_Iallreduce конвейеризуется с
+// генерацией так же, как MPI_Ireduce; рукописные алгоритмы блокирующие.
+void allreduce_process(int rank, const Options& opts) {
+    const MPI_Op min_fibonacci_op = reduce_ops::get(reduce_ops::Op::MinFibonacci);
+    if (opts.n <= PRINT_LIMIT) {
+        print_generated(opts, rank);
+    }
+
+    const long long num_segments = (opts.n + opts.segment - 1) / opts.segment;
+    vector<vector<int>> buffers(SEGMENTS_IN_FLIGHT, vector<int>(min<long long>(opts.segment, opts.n)));
+    MPI_Request requests[SEGMENTS_IN_FLIGHT] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    ResultSummary result;
+    auto segment_count = [&](long long segment) {
+        return (int)min<long long>(opts.segment, opts.n - segment * opts.segment);
+    };
+
+    phase_timer::PhaseTimer timer(opts.phases);
+    timer.start();
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+    for (long long segment = 0; segment < num_segments; ++segment) {
+        const int slot = (int)(segment % SEGMENTS_IN_FLIGHT);
+        const int count = segment_count(segment);
+        if (opts.allreduce == AllreduceMode::Library) {
+            if (segment >= SEGMENTS_IN_FLIGHT) {
+                MPI_Wait(&requests[slot], MPI_STATUS_IGNORE);
+                result.consume(opts, span<int>(buffers[slot].data(), segment_count(segment - SEGMENTS_IN_FLIGHT)));
+            }
+            generate_segment(opts, rank, segment * opts.segment, count, buffers[slot].data(), requests);
+            MPI_Iallreduce(MPI_IN_PLACE, buffers[slot].data(), count, MPI_INT, min_fibonacci_op, MPI_COMM_WORLD,
+                &requests[slot]);
+        }
+        else {
+            generate_segment(opts, rank, segment * opts.segment, count, buffers[slot].data(), requests);
+            allreduce(opts.allreduce, buffers[slot].data(), count, MPI_INT, min_fibonacci_op, MPI_COMM_WORLD);
+            result.consume(opts, span<int>(buffers[slot].data(), count));
+        }
+    }
+    if (opts.allreduce == AllreduceMode::Library) {
+        for (long long segment = max(0LL, num_segments - SEGMENTS_IN_FLIGHT); segment < num_segments; ++segment) {
+            const int slot = (int)(segment % SEGMENTS_IN_FLIGHT);
+            MPI_Wait(&requests[slot], MPI_STATUS_IGNORE);
+            result.consume(opts, span<int>(buffers[slot].data(), segment_count(segment)));
+        }
+    }
+    const double elapsed = MPI_Wtime() - start;
+    timer.mark("allreduce");
+
+    // Проверка, что все процессы получили одинаковый результат
+    long long checksums[2] = { result.checksum, -result.checksum };
+    MPI_Allreduce(MPI_IN_PLACE, checksums, 2, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (rank == MASTER_RANK) {
+        result.print(opts, elapsed);
+        cout << (checksums[0] == -checksums[1] ? "All ranks hold the same result" : "RANKS DISAGREE") << endl;
     }
 }
 
-// Функция для нахождения минимального числа Фибоначчи, превосходящего заданное значение
-int find_min_fibonacci_greater_than(int num) {
-    if (num <= 0) return 0;
+// Прежний перебор последовательности с (1, 1), в 64-битной арифметике (эталон для бенчмарка)
+uint64_t find_min_fibonacci_greater_than_loop(uint64_t num) {
+    if (num == 0) return 0;
 
-    int a = 1, b = 1;
+    uint64_t a = 1, b = 1;
     while (b <= num) {
-        int next = a + b;
+        uint64_t next = a + b;
         a = b;
         b = next;
     }
     return b;
 }
+
+// Скорость поиска (запросов в секунду) на случайных 32- и 64-битных входах:
+// перебор последовательности против двоичного поиска по таблице
+template <integral T>
+void bench_fibonacci_type(const char* name, T max_value) {
+    const size_t n = 1 << 22;
+    mt19937_64 generator(42);
+    uniform_int_distribution<T> distribution(0, max_value);
+    vector<T> data(n), table_results(n);
+    for (T& value : data) {
+        value = distribution(generator);
+    }
+
+    double start = MPI_Wtime();
+    uint64_t loop_checksum = 0;
+    for (T value : data) {
+        loop_checksum += find_min_fibonacci_greater_than_loop(static_cast<uint64_t>(value));
+    }
+    const double loop_time = MPI_Wtime() - start;
+
+    start = MPI_Wtime();
+    find_min_fibonacci_greater_than<T>(data, table_results);
+    const double table_time = MPI_Wtime() - start;
+
+    uint64_t table_checksum = 0;
+    for (T value : table_results) {
+        table_checksum += static_cast<uint64_t>(value);
+    }
+
+    cout << name << ": loop " << n / loop_time / 1e6 << " M lookups/s, table " << n / table_time / 1e6
+        << " M lookups/s, speedup " << loop_time / table_time
+        << (loop_checksum == table_checksum ? ", results match" : ", RESULTS DIFFER") << endl;
+}
+
+void bench_fibonacci() {
+    // Верхние границы выбраны так, чтобы ответ помещался в тип
+    bench_fibonacci_type<int32_t>("int32", 1836311902);
+    bench_fibonacci_type<int64_t>("int64", 7540113804746346428);
+}
+
+// Среднее время одной редукции (максимум по процессам comm) за reps повторов
+template <typename Reduce>
+double time_reduce(int reps, Reduce reduce, MPI_Comm comm = MPI_COMM_WORLD) {
+    reduce(); // Прогрев: создание операции, выделение страниц
+    MPI_Barrier(comm);
+    const double start = MPI_Wtime();
+    for (int rep = 0; rep < reps; ++rep) {
+        reduce();
+    }
+    double elapsed = (MPI_Wtime() - start) / reps;
+    MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, comm);
+    return elapsed;
+}
+
+// Сравнение MPI_Reduce со встроенной операцией и с операцией reduce_ops для одной длины
+template <typename T, typename Builtin>
+void bench_ops_length(int rank, const char* name, int length, MPI_Datatype builtin_type, MPI_Op builtin_op,
+    MPI_Datatype library_type, reduce_ops::Op library_op) {
+    vector<T> send(length), builtin_result(rank == MASTER_RANK ? length : 0), library_result(builtin_result.size());
+    vector<Builtin> builtin_send(length);
+    for (int i = 0; i < length; ++i) {
+        const double value = static_cast<double>(counter_random(0, rank, i) % 2001) - 1000;
+        if constexpr (requires { send[i].index; }) {
+            send[i] = { static_cast<decltype(send[i].value)>(value), rank };
+            builtin_send[i] = { send[i].value, rank };
+        }
+        else {
+            send[i] = static_cast<T>(value);
+            builtin_send[i] = send[i];
+        }
+    }
+    vector<Builtin> builtin_recv(builtin_result.size());
+
+    const int reps = (int)clamp(10000000LL / length, 3LL, 1000LL);
+    const MPI_Op op = reduce_ops::get(library_op);
+    const double builtin_time = time_reduce(reps, [&] {
+        MPI_Reduce(builtin_send.data(), builtin_recv.data(), length, builtin_type, builtin_op, MASTER_RANK,
+            MPI_COMM_WORLD);
+    });
+    const double library_time = time_reduce(reps, [&] {
+        MPI_Reduce(send.data(), library_result.data(), length, library_type, op, MASTER_RANK, MPI_COMM_WORLD);
+    });
+
+    if (rank == MASTER_RANK) {
+        bool match = true;
+        for (int i = 0; i < length; ++i) {
+            if constexpr (requires { send[i].index; }) {
+                match &= builtin_recv[i].value == library_result[i].value && builtin_recv[i].index == library_result[i].index;
+            }
+            else {
+                match &= builtin_recv[i] == library_result[i];
+            }
+        }
+        cout << name << "\t" << length << "\t" << builtin_time * 1e6 << "\t" << library_time * 1e6 << "\t"
+            << builtin_time / library_time << "\t" << (match ? "yes" : "NO") << endl;
+    }
+}
+
+// Встроенная пара MPI_DOUBLE_INT для сравнения с MinLoc<double>
+struct DoubleInt {
+    double value;
+    int index;
+};
+
+// Бенчмарк операций reduce_ops против встроенных MPI_MIN/MPI_MINLOC для длин 1, 10, ..., max_length
+void bench_ops(int rank, const Options& opts) {
+    if (rank == MASTER_RANK) {
+        cout << "op\tlength\tbuiltin_us\treduce_ops_us\tspeedup\tmatch" << endl;
+    }
+    for (long long length = 1; length <= opts.max_length && length <= INT_MAX; length *= 10) {
+        bench_ops_length<int32_t, int32_t>(rank, "min/int32", (int)length, MPI_INT32_T, MPI_MIN, MPI_INT32_T,
+            reduce_ops::Op::Min);
+        bench_ops_length<double, double>(rank, "min/double", (int)length, MPI_DOUBLE, MPI_MIN, MPI_DOUBLE,
+            reduce_ops::Op::Min);
+        bench_ops_length<reduce_ops::MinLoc<double>, DoubleInt>(rank, "minloc/double", (int)length, MPI_DOUBLE_INT,
+            MPI_MINLOC, reduce_ops::min_loc_type<double>(), reduce_ops::Op::MinLoc);
+    }
+}
+
+// Бенчмарк allreduce операцией Op::Min на int32: библиотечный MPI_Allreduce против рекурсивного
+// удвоения и Рабензейфнера. Число процессов 2, 4, ... и p (подкоммуникаторы из первых рангов),
+// длины 1, 10, ..., max_length. Полоса — байты вектора, делённые на время.
+void bench_allreduce(int rank, int num_processes, const Options& opts) {
+    const MPI_Op op = reduce_ops::get(reduce_ops::Op::Min);
+    const AllreduceMode modes[] = { AllreduceMode::Library, AllreduceMode::RecursiveDoubling, AllreduceMode::Rabenseifner };
+
+    vector<int> sizes;
+    for (int size = 2; size < num_processes; size *= 2) {
+        sizes.push_back(size);
+    }
+    sizes.push_back(num_processes);
+
+    if (rank == MASTER_RANK) {
+        cout << "ranks\tbytes\tlibrary_us\tlibrary_GB/s\tdoubling_us\tdoubling_GB/s\trabenseifner_us"
+            << "\trabenseifner_GB/s\tmatch" << endl;
+    }
+    for (int size : sizes) {
+        MPI_Comm comm;
+        MPI_Comm_split(MPI_COMM_WORLD, rank < size ? 0 : MPI_UNDEFINED, rank, &comm);
+        if (comm == MPI_COMM_NULL) {
+            continue;
+        }
+        for (long long length = 1; length <= opts.max_length && length <= INT_MAX; length *= 10) {
+            const int count = (int)length;
+            vector<int> input(count), buffer(count), reference(count);
+            for (int i = 0; i < count; ++i) {
+                input[i] = static_cast<int>(counter_random(opts.seed, rank, i) % 2001) - 1000;
+            }
+            const int reps = (int)clamp(10000000LL / length, 3LL, 1000LL);
+
+            double times[3];
+            bool match = true;
+            for (int m = 0; m < 3; ++m) {
+                times[m] = time_reduce(reps, [&] {
+                    buffer = input;
+                    allreduce(modes[m], buffer.data(), count, MPI_INT, op, comm);
+                }, comm);
+                if (m == 0) {
+                    reference = buffer;
+                }
+                match &= buffer == reference;
+            }
+            MPI_Allreduce(MPI_IN_PLACE, &match, 1, MPI_CXX_BOOL, MPI_LAND, comm);
+
+            if (rank == MASTER_RANK) {
+                const double bytes = static_cast<double>(length) * sizeof(int);
+                cout << size << "\t" << (long long)bytes;
+                for (double time : times) {
+                    cout << "\t" << time * 1e6 << "\t" << bytes / time / 1e9;
+                }
+                cout << "\t" << (match ? "yes" : "NO") << endl;
+            }
+        }
+        MPI_Comm_free(&comm);
+    }
+}
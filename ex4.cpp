@@ -1,14 +1,204 @@
 #include <mpi.h>
 #include <iostream>
 #include <cstring> // Для strcpy и strcat
+#include <cstdlib> // Для strtoull
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <thread> // Для параллельного дублирования
+#include <algorithm>
+#include <string_view>
+#include <map>
+#include <climits>
+#include <string>
+#include <fstream> // Для чтения входного текста и записи результата
+#include "phase_timer.h" // Для замера фаз в бенчмарке (--phases)
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h> // Для SSSE3-ядра дублирования (pshufb)
+#define EX4_X86_SIMD 1
+#endif
 
 using namespace std;
 
 const int MASTER_RANK = 0;
 const int MAX_STR_LEN = 6; // Длина исходной строки без дублирования
+const size_t TRIAD_LEN = 3; // Длина триады
+
+// Параметры запуска, полученные из командной строки
+struct Options {
+    bool bench_duplicate = false; // Бенчмарк дублирования триад
+    bool bench_datatypes = false; // Бенчмарк передачи: indexed, непрерывная, дублирующий тип
+    size_t size = size_t(1) << 28; // Размер входного текста (наибольшего сообщения) бенчмарка в байтах
+    unsigned threads = max(1u, thread::hardware_concurrency()); // Потоков дублирования
+    bool distributed = false; // Распределённое дублирование большого текста всеми процессами
+    string input; // Входной текст распределённого режима (пусто — сгенерированный текст из size байт)
+    string output; // Файл результата распределённого режима (пусто — без записи)
+    bool mpi_io = false; // Параллельная запись результата через MPI-IO вместо сборки на master
+    bool phases = false; // Печать длительности фаз распределённого режима для bench_driver
+};
+
+const size_t PRINT_LIMIT = 64; // Результат распределённого режима выводится целиком только для коротких текстов
+
+// Разбор аргументов вида --distributed --input=path --output=path --mpi-io --bench-duplicate
+// --bench-datatypes --size=BYTES --threads=T --phases
+Options parse_options(int argc, char** argv) {
+    Options opts;
+    bool threads_given = false;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--bench-duplicate") {
+            opts.bench_duplicate = true;
+        }
+        else if (arg == "--bench-datatypes") {
+            opts.bench_datatypes = true;
+        }
+        else if (arg.starts_with("--size=")) {
+            opts.size = strtoull(argv[i] + 7, nullptr, 10);
+        }
+        else if (arg.starts_with("--threads=")) {
+            opts.threads = max(1u, (unsigned)strtoul(argv[i] + 10, nullptr, 10));
+            threads_given = true;
+        }
+        else if (arg == "--distributed") {
+            opts.distributed = true;
+        }
+        else if (arg.starts_with("--input=")) {
+            opts.input = string(arg.substr(8));
+        }
+        else if (arg.starts_with("--output=")) {
+            opts.output = string(arg.substr(9));
+        }
+        else if (arg == "--mpi-io") {
+            opts.mpi_io = true;
+        }
+        else if (arg == "--phases") {
+            opts.phases = true;
+        }
+    }
+    // В распределённом режиме ядра уже заняты процессами: по умолчанию один поток на процесс
+    if (opts.distributed && !threads_given) {
+        opts.threads = 1;
+    }
+    return opts;
+}
+
+// Скалярное дублирование триад: каждая триада in записывается в out дважды подряд,
+// неполная последняя триада (n % 3 байт) тоже дублируется. out вмещает 2 * n байт.
+void duplicate_triads_scalar(const char* in, size_t n, char* out) {
+    const size_t full = n - n % TRIAD_LEN;
+    for (size_t i = 0; i < full; i += TRIAD_LEN, out += 2 * TRIAD_LEN) {
+        memcpy(out, in + i, TRIAD_LEN);
+        memcpy(out + TRIAD_LEN, in + i, TRIAD_LEN);
+    }
+    const size_t tail = n - full;
+    memcpy(out, in + full, tail);
+    memcpy(out + tail, in + full, tail);
+}
+
+#ifdef EX4_X86_SIMD
+// Маски pshufb для блока из 24 входных байт (8 триад), дающего 48 выходных байт.
+// Выходной 16-байтный фрагмент c берёт байты из окна in[base[c], base[c] + 16).
+struct TriadShuffle {
+    array<size_t, 3> base;
+    array<array<char, 16>, 3> mask;
+};
+
+constexpr TriadShuffle TRIAD_SHUFFLE = [] {
+    TriadShuffle shuffle{};
+    for (size_t c = 0; c < 3; ++c) {
+        // Номер входного байта для выходного байта j
+        auto source = [](size_t j) { return j / (2 * TRIAD_LEN) * TRIAD_LEN + j % TRIAD_LEN; };
+        size_t base = source(16 * c);
+        for (size_t j = 16 * c; j < 16 * (c + 1); ++j) {
+            base = min(base, source(j));
+        }
+        shuffle.base[c] = base;
+        for (size_t j = 0; j < 16; ++j) {
+            shuffle.mask[c][j] = static_cast<char>(source(16 * c + j) - base);
+        }
+    }
+    return shuffle;
+}();
+static_assert(TRIAD_SHUFFLE.base[2] + 16 <= 32, "окно последнего фрагмента выходит за 32 байта");
+
+// Дублирование триад байтовыми перестановками pshufb: 24 входных байта за итерацию.
+// Окна читают до 32 байт вперёд, поэтому хвост короче 32 байт обрабатывается скалярно.
+__attribute__((target("ssse3"))) void duplicate_triads_ssse3(const char* in, size_t n, char* out) {
+    const __m128i mask0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TRIAD_SHUFFLE.mask[0].data()));
+    const __m128i mask1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TRIAD_SHUFFLE.mask[1].data()));
+    const __m128i mask2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TRIAD_SHUFFLE.mask[2].data()));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 8 * TRIAD_LEN, out += 16 * TRIAD_LEN) {
+        const __m128i window0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + TRIAD_SHUFFLE.base[0]));
+        const __m128i window1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + TRIAD_SHUFFLE.base[1]));
+        const __m128i window2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + TRIAD_SHUFFLE.base[2]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(window0, mask0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_shuffle_epi8(window1, mask1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 32), _mm_shuffle_epi8(window2, mask2));
+    }
+    duplicate_triads_scalar(in + i, n - i, out);
+}
+#endif
+
+// Дублирование триад самым быстрым доступным ядром (выбор один раз)
+void duplicate_triads(const char* in, size_t n, char* out) {
+    using Kernel = void (*)(const char*, size_t, char*);
+    static const Kernel kernel = [] {
+#ifdef EX4_X86_SIMD
+        if (__builtin_cpu_supports("ssse3")) return static_cast<Kernel>(duplicate_triads_ssse3);
+#endif
+        return static_cast<Kernel>(duplicate_triads_scalar);
+    }();
+    kernel(in, n, out);
+}
+
+// Дублирование триад, разделённое между threads потоками по границам триад.
+// Поток t пишет свой непересекающийся диапазон out, синхронизация не нужна.
+void duplicate_triads_parallel(const char* in, size_t n, char* out, unsigned threads) {
+    const size_t triads = n / TRIAD_LEN;
+    threads = static_cast<unsigned>(min<size_t>(threads, max<size_t>(1, triads)));
+    if (threads <= 1) {
+        duplicate_triads(in, n, out);
+        return;
+    }
+
+    // Первая триада потока t; последний поток забирает и неполную триаду
+    const auto first_triad = [&](unsigned t) { return triads / threads * t + min<size_t>(t, triads % threads); };
+    const auto run = [&](unsigned t) {
+        const size_t begin = first_triad(t) * TRIAD_LEN;
+        const size_t end = t + 1 == threads ? n : first_triad(t + 1) * TRIAD_LEN;
+        duplicate_triads(in + begin, end - begin, out + 2 * begin);
+    };
+    vector<thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(run, t);
+    }
+    run(0);
+    for (thread& worker : pool) {
+        worker.join();
+    }
+}
 
 // Функция для дублирования строки с учетом триад
 void duplicate_string(char* str) {
+    char temp[MAX_STR_LEN * 2 + 1] = {0}; // Массив для строки после дублирования
+    duplicate_triads(str, MAX_STR_LEN, temp);
+
+    // Копируем результат обратно в исходную строку
+    memcpy(str, temp, MAX_STR_LEN * 2 + 1);
+}
+
+// Прежняя реализация через strncat (эталон для бенчмарка): strncat каждый раз ищет конец
+// temp с начала, поэтому на длинных строках она квадратична.
+// strncat здесь копирует лишь триаду из длинной строки — это и нужно, поэтому
+// предупреждение GCC об усечении (-Wstringop-truncation) в функции отключено
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstringop-truncation"
+#endif
+void duplicate_string_strncat(char* str) {
     char temp[MAX_STR_LEN * 2 + 1] = {0}; // Массив для строки после дублирования
     int triad_len = 3; // Длина триады
     int num_triads = MAX_STR_LEN / triad_len; // Количество триад
@@ -22,18 +212,135 @@ void duplicate_string(char* str) {
     // Копируем результат обратно в исходную строку
     strncpy(str, temp, MAX_STR_LEN * 2 + 1);
 }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 
-inline void master_process(int num_processes, int count);
-inline void slave_process(int rank, int count);
+// Кэш раскладок передачи строк: каждый производный тип строится и фиксируется один раз
+// и освобождается вместе с кэшем (до MPI_Finalize)
+class DatatypeCache {
+public:
+    // Передаваемая раскладка: count элементов типа type
+    struct Layout {
+        MPI_Datatype type;
+        int count;
+    };
 
-int main(int argc, char** argv) {
-    int count = 1; // Мы передаем одну строку
+    DatatypeCache() = default;
+    DatatypeCache(const DatatypeCache&) = delete;
+    DatatypeCache& operator=(const DatatypeCache&) = delete;
+    ~DatatypeCache() {
+        for (auto& [key, type] : types_) {
+            MPI_Type_free(&type);
+        }
+    }
+
+    // Раскладка блоков MPI_CHAR. Непрерывная раскладка (блоки подряд с нулевого смещения)
+    // передаётся как count байт без производного типа и упаковки.
+    Layout chars(const vector<int>& block_lengths, const vector<int>& displacements) {
+        int total = 0;
+        bool contiguous = true;
+        for (size_t i = 0; i < block_lengths.size(); ++i) {
+            contiguous = contiguous && displacements[i] == total;
+            total += block_lengths[i];
+        }
+        if (contiguous) {
+            return { MPI_CHAR, total };
+        }
+
+        vector<int> key = { KEY_INDEXED };
+        key.insert(key.end(), block_lengths.begin(), block_lengths.end());
+        key.insert(key.end(), displacements.begin(), displacements.end());
+        return { find_or_create(key, [&](MPI_Datatype* type) {
+            MPI_Type_indexed((int)block_lengths.size(), block_lengths.data(), displacements.data(), MPI_CHAR, type);
+        }), 1 };
+    }
+
+    // Тип отправки, читающий каждую триаду n-байтной строки дважды: получатель принимает
+    // 2 * n байт MPI_CHAR уже продублированного текста без отдельного прохода дублирования.
+    // Неполная последняя триада тоже дублируется, как в duplicate_triads.
+    Layout duplication(int n) {
+        return { find_or_create({ KEY_DUPLICATION, n }, [&](MPI_Datatype* type) {
+            const int full = n - n % (int)TRIAD_LEN;
+            const int tail = n - full;
+            const MPI_Aint twice[2] = { 0, 0 };
+
+            // Триада дважды, с протяжённостью одной триады, повторённая full / 3 раз
+            MPI_Datatype triad_twice, triad_step, triads;
+            MPI_Type_create_hindexed_block(2, (int)TRIAD_LEN, twice, MPI_CHAR, &triad_twice);
+            MPI_Type_create_resized(triad_twice, 0, TRIAD_LEN, &triad_step);
+            MPI_Type_contiguous(full / (int)TRIAD_LEN, triad_step, &triads);
+
+            // Неполная триада дважды
+            MPI_Datatype tail_twice;
+            MPI_Type_create_hindexed_block(2, tail, twice, MPI_CHAR, &tail_twice);
+
+            const int lengths[2] = { 1, 1 };
+            const MPI_Aint displacements[2] = { 0, full };
+            const MPI_Datatype parts[2] = { triads, tail_twice };
+            MPI_Type_create_struct(2, lengths, displacements, parts, type);
+            for (MPI_Datatype* part : { &triad_twice, &triad_step, &triads, &tail_twice }) {
+                MPI_Type_free(part);
+            }
+        }), 1 };
+    }
+
+private:
+    static const int KEY_INDEXED = 0;
+    static const int KEY_DUPLICATION = 1;
+
+    template <typename Create>
+    MPI_Datatype find_or_create(const vector<int>& key, Create create) {
+        auto it = types_.find(key);
+        if (it == types_.end()) {
+            MPI_Datatype type;
+            create(&type);
+            MPI_Type_commit(&type);
+            it = types_.emplace(key, type).first;
+        }
+        return it->second;
+    }
+
+    map<vector<int>, MPI_Datatype> types_;
+};
 
+inline void master_process(int num_processes, DatatypeCache& cache);
+inline void slave_process(int rank, DatatypeCache& cache);
+inline void bench_duplicate(const Options& opts);
+inline void bench_datatypes(int rank, const Options& opts);
+inline bool distributed_process(int rank, int num_processes, const Options& opts);
+
+int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
     int rank, num_processes;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
 
+    const Options opts = parse_options(argc, argv);
+
+    // Бенчмарк дублирования выполняется только на master-процессе
+    if (opts.bench_duplicate) {
+        if (rank == MASTER_RANK) {
+            bench_duplicate(opts);
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Бенчмарк передачи выполняется процессами 0 и 1
+    if (opts.bench_datatypes && num_processes >= 2) {
+        bench_datatypes(rank, opts);
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Распределённый режим работает при любом числе процессов
+    if (opts.distributed) {
+        const bool ok = distributed_process(rank, num_processes, opts);
+        MPI_Finalize();
+        return ok ? 0 : 1;
+    }
+
     // Убедимся, что количество процессов хотя бы 2
     if (num_processes < 2) {
         if (rank == MASTER_RANK) {
@@ -43,17 +350,33 @@ int main(int argc, char** argv) {
         return 1; // Завершаем программу с ошибкой
     }
 
-    if (rank == MASTER_RANK) {
-        master_process(num_processes, count);
-    } else {
-        slave_process(rank, count);
+    {
+        DatatypeCache cache; // Типы освобождаются до MPI_Finalize
+        if (rank == MASTER_RANK) {
+            master_process(num_processes, cache);
+        } else {
+            slave_process(rank, cache);
+        }
     }
 
     MPI_Finalize();
     return 0;
 }
 
-void master_process(int num_processes, int count) {
+// Раскладка продублированной строки: MAX_STR_LEN * 2 блоков длины 1 с последовательными смещениями
+vector<int> str_layout_lengths() {
+    return vector<int>(MAX_STR_LEN * 2, 1); // Каждый блок имеет длину 1
+}
+
+vector<int> str_layout_displacements() {
+    vector<int> displacements(MAX_STR_LEN * 2);
+    for (int i = 0; i < MAX_STR_LEN * 2; ++i) {
+        displacements[i] = i; // Смещения идут последовательно
+    }
+    return displacements;
+}
+
+void master_process(int num_processes, DatatypeCache& cache) {
     // Строка для передачи
     char str[MAX_STR_LEN * 2 + 1] = "abcdef";  // Исходная строка
 
@@ -61,48 +384,306 @@ void master_process(int num_processes, int count) {
     // Дублируем строку
     duplicate_string(str);
 
-    // Создаем тип MPI для передачи строки
-    int block_lengths[MAX_STR_LEN * 2];
-    int displacements[MAX_STR_LEN * 2];
-    for (int i = 0; i < MAX_STR_LEN * 2; ++i) {
-        block_lengths[i] = 1; // Каждый блок имеет длину 1
-        displacements[i] = i; // Смещения идут последовательно
-    }
+    // Раскладка строки из кэша: она непрерывна, поэтому передаётся сырыми байтами
+    const DatatypeCache::Layout layout = cache.chars(str_layout_lengths(), str_layout_displacements());
 
-    MPI_Datatype str_type;
-    MPI_Type_indexed(MAX_STR_LEN * 2, block_lengths, displacements, MPI_CHAR, &str_type);
-    MPI_Type_commit(&str_type);
-
-    // Отправляем строку процессу-слейву
-    MPI_Send(str, 1, str_type, 1, 0, MPI_COMM_WORLD);
+    // Отправляем строку каждому процессу-слейву (иначе слейвы с rank > 1 ждали бы вечно)
+    for (int slave = 1; slave < num_processes; ++slave) {
+        MPI_Send(str, layout.count, layout.type, slave, 0, MPI_COMM_WORLD);
+    }
     cout << "Master process sent duplicated string." << endl;
-
-    // Освобождаем тип
-    MPI_Type_free(&str_type);
 }
 
-void slave_process(int rank, int count) {
+void slave_process(int rank, DatatypeCache& cache) {
     // Массив для получения строки
     char received_str[MAX_STR_LEN * 2 + 1] = {0};
 
-    // Создаем тип MPI для получения строки
-    int block_lengths[MAX_STR_LEN * 2];
-    int displacements[MAX_STR_LEN * 2];
-    for (int i = 0; i < MAX_STR_LEN * 2; ++i) {
-        block_lengths[i] = 1; // Каждый блок имеет длину 1
-        displacements[i] = i; // Смещения идут последовательно
-    }
-
-    MPI_Datatype str_type;
-    MPI_Type_indexed(MAX_STR_LEN * 2, block_lengths, displacements, MPI_CHAR, &str_type);
-    MPI_Type_commit(&str_type);
+    // Раскладка строки та же, что у master-процесса
+    const DatatypeCache::Layout layout = cache.chars(str_layout_lengths(), str_layout_displacements());
 
     // Получаем строку от мастер-процесса
-    MPI_Recv(received_str, 1, str_type, MASTER_RANK, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Recv(received_str, layout.count, layout.type, MASTER_RANK, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
     // Выводим полученную строку
     cout << "Slave process " << rank << " received string: " << received_str << endl;
+}
+
+// Лучшее из трёх время выполнения run
+template <typename Run>
+double best_time(Run run) {
+    double best = 1e300;
+    for (int rep = 0; rep < 3; ++rep) {
+        const double start = MPI_Wtime();
+        run();
+        best = min(best, MPI_Wtime() - start);
+    }
+    return best;
+}
+
+// Скорость дублирования (ГБ/с входного текста) на тексте opts.size байт: прежняя функция
+// на 6-байтных строках, скалярное ядро, SIMD-ядро и SIMD-ядро в opts.threads потоках
+void bench_duplicate(const Options& opts) {
+    const size_t n = opts.size;
+    vector<char> text(n), reference(2 * n), result(2 * n);
+    for (size_t i = 0; i < n; ++i) {
+        text[i] = static_cast<char>('a' + i % 26);
+    }
+    const auto report = [&](const string& name, size_t bytes, double seconds, bool match) {
+        cout << name << ": " << bytes / seconds / 1e9 << " GB/s" << (match ? "" : ", RESULTS DIFFER") << endl;
+    };
+
+    // Прежняя функция поддерживает только строки по MAX_STR_LEN байт; замер на префиксе
+    const size_t legacy_n = min<size_t>(n, size_t(1) << 26) / MAX_STR_LEN * MAX_STR_LEN;
+    const double legacy_time = best_time([&] {
+        for (size_t i = 0; i < legacy_n; i += MAX_STR_LEN) {
+            char str[MAX_STR_LEN * 2 + 1] = {0};
+            memcpy(str, text.data() + i, MAX_STR_LEN);
+            duplicate_string_strncat(str);
+            memcpy(reference.data() + 2 * i, str, 2 * MAX_STR_LEN);
+        }
+    });
+    report("strncat (6-byte strings)", legacy_n, legacy_time, true);
+
+    const double scalar_time = best_time([&] { duplicate_triads_scalar(text.data(), n, reference.data()); });
+    report("scalar", n, scalar_time, true);
+
+    const double simd_time = best_time([&] { duplicate_triads(text.data(), n, result.data()); });
+    report("simd, 1 thread", n, simd_time, result == reference);
+
+    memset(result.data(), 0, result.size());
+    const double parallel_time = best_time([&] { duplicate_triads_parallel(text.data(), n, result.data(), opts.threads); });
+    report("simd, " + to_string(opts.threads) + " threads", n, parallel_time, result == reference);
+}
+
+const int TAG_BENCH = 1; // Тег сообщений бенчмарка передачи
+
+// Среднее время передачи rank 0 -> rank 1 (с подтверждением нулевой длины) за reps повторов
+template <typename Send, typename Receive>
+double time_transfer(int rank, int reps, Send send, Receive receive) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+    for (int rep = 0; rep < reps; ++rep) {
+        if (rank == MASTER_RANK) {
+            send();
+            MPI_Recv(nullptr, 0, MPI_CHAR, 1, TAG_BENCH, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        else if (rank == 1) {
+            receive();
+            MPI_Send(nullptr, 0, MPI_CHAR, MASTER_RANK, TAG_BENCH, MPI_COMM_WORLD);
+        }
+    }
+    return (MPI_Wtime() - start) / reps;
+}
+
+// Бенчмарк передачи строки от 1 КБ до opts.size байт между процессами 0 и 1:
+// indexed — прежний тип из блоков по 1 байту (только до INDEXED_LIMIT, его массивы велики);
+// contiguous — та же раскладка из кэша, т.е. сырые байты;
+// dup_derived — исходный текст с дублирующим типом, получатель принимает 2n байт;
+// dup_pack — duplicate_triads в буфер и отправка 2n сырых байт.
+// Время в микросекундах, полоса — принятые получателем байты за секунду.
+void bench_datatypes(int rank, const Options& opts) {
+    const size_t INDEXED_LIMIT = size_t(1) << 24;
+    const size_t max_size = min<size_t>(opts.size, INT_MAX / 2);
+    DatatypeCache cache;
+    if (rank == MASTER_RANK) {
+        cout << "bytes\tindexed_us\tindexed_GB/s\tcontiguous_us\tcontiguous_GB/s\tdup_derived_us\tdup_derived_GB/s"
+            << "\tdup_pack_us\tdup_pack_GB/s\tmatch" << endl;
+    }
+    for (size_t n = 1024; n <= max_size; n *= 4) {
+        const int count = (int)n;
+        const int reps = (int)clamp<size_t>((size_t(1) << 28) / n, 3, 1000);
+        vector<char> text(rank == MASTER_RANK ? n : 0), packed(rank == MASTER_RANK ? 2 * n : 0);
+        vector<char> received(rank == 1 ? 2 * n : 0), expected(rank == 1 ? 2 * n : 0);
+        for (size_t i = 0; i < text.size(); ++i) {
+            text[i] = static_cast<char>('a' + i % 26);
+        }
+        if (rank == 1) {
+            // Получатель генерирует тот же текст и дублирует его для проверки
+            vector<char> source(n);
+            for (size_t i = 0; i < n; ++i) {
+                source[i] = static_cast<char>('a' + i % 26);
+            }
+            duplicate_triads(source.data(), n, expected.data());
+        }
 
-    // Освобождаем тип
-    MPI_Type_free(&str_type);
+        double indexed_time = 0;
+        if (n <= INDEXED_LIMIT) {
+            vector<int> displacements(n);
+            for (int i = 0; i < count; ++i) {
+                displacements[i] = i;
+            }
+            MPI_Datatype indexed;
+            MPI_Type_create_indexed_block(count, 1, displacements.data(), MPI_CHAR, &indexed);
+            MPI_Type_commit(&indexed);
+            indexed_time = time_transfer(rank, reps,
+                [&] { MPI_Send(text.data(), 1, indexed, 1, TAG_BENCH, MPI_COMM_WORLD); },
+                [&] { MPI_Recv(received.data(), 1, indexed, MASTER_RANK, TAG_BENCH, MPI_COMM_WORLD, MPI_STATUS_IGNORE); });
+            MPI_Type_free(&indexed);
+        }
+
+        const DatatypeCache::Layout layout = cache.chars({ count }, { 0 });
+        const double contiguous_time = time_transfer(rank, reps,
+            [&] { MPI_Send(text.data(), layout.count, layout.type, 1, TAG_BENCH, MPI_COMM_WORLD); },
+            [&] { MPI_Recv(received.data(), layout.count, layout.type, MASTER_RANK, TAG_BENCH, MPI_COMM_WORLD,
+                MPI_STATUS_IGNORE); });
+
+        const DatatypeCache::Layout duplication = cache.duplication(count);
+        const double derived_time = time_transfer(rank, reps,
+            [&] { MPI_Send(text.data(), duplication.count, duplication.type, 1, TAG_BENCH, MPI_COMM_WORLD); },
+            [&] { MPI_Recv(received.data(), 2 * count, MPI_CHAR, MASTER_RANK, TAG_BENCH, MPI_COMM_WORLD,
+                MPI_STATUS_IGNORE); });
+        bool match = received == expected;
+
+        const double pack_time = time_transfer(rank, reps,
+            [&] {
+                duplicate_triads(text.data(), n, packed.data());
+                MPI_Send(packed.data(), 2 * count, MPI_CHAR, 1, TAG_BENCH, MPI_COMM_WORLD);
+            },
+            [&] { MPI_Recv(received.data(), 2 * count, MPI_CHAR, MASTER_RANK, TAG_BENCH, MPI_COMM_WORLD,
+                MPI_STATUS_IGNORE); });
+        match = match && received == expected;
+        MPI_Bcast(&match, 1, MPI_CXX_BOOL, 1, MPI_COMM_WORLD);
+
+        if (rank == MASTER_RANK) {
+            const auto column = [](double seconds, double bytes) {
+                if (seconds == 0) return string("-\t-");
+                return to_string(seconds * 1e6) + "\t" + to_string(bytes / seconds / 1e9);
+            };
+            cout << n << "\t" << column(indexed_time, (double)n) << "\t" << column(contiguous_time, (double)n) << "\t"
+                << column(derived_time, 2.0 * n) << "\t" << column(pack_time, 2.0 * n) << "\t"
+                << (match ? "yes" : "NO") << endl;
+        }
+    }
+}
+
+// Чтение входного текста распределённого режима на master: файл opts.input целиком
+// или сгенерированный текст из opts.size букв
+vector<char> load_text(const Options& opts) {
+    if (opts.input.empty()) {
+        vector<char> text(opts.size);
+        for (size_t i = 0; i < text.size(); ++i) {
+            text[i] = static_cast<char>('a' + i % 26);
+        }
+        return text;
+    }
+    ifstream file(opts.input, ios::binary | ios::ate);
+    if (!file) {
+        cerr << "Error: cannot open input file " << opts.input << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    vector<char> text(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(text.data(), (streamsize)text.size());
+    return text;
+}
+
+// Распределённое дублирование: master делит текст по границам триад и рассылает части
+// через MPI_Scatterv, каждый процесс дублирует свою часть, результат собирается через
+// MPI_Gatherv на master или пишется всеми процессами в файл через MPI-IO (--mpi-io)
+// по смещению 2 * (начало части). Если результат больше INT_MAX байт, счётчиков int
+// MPI_Gatherv не хватает, и при заданном --output он пишется через MPI-IO автоматически.
+// Возвращает false, если текст не помещается в счётчики MPI.
+bool distributed_process(int rank, int num_processes, const Options& opts) {
+    vector<char> text;
+    unsigned long long n = 0;
+    if (rank == MASTER_RANK) {
+        text = load_text(opts);
+        n = text.size();
+    }
+    MPI_Bcast(&n, 1, MPI_UNSIGNED_LONG_LONG, MASTER_RANK, MPI_COMM_WORLD);
+
+    // Части — целые триады; последнему процессу достаётся и неполная триада. Счётчики MPI
+    // имеют тип int, поэтому продублированная часть не должна превышать INT_MAX байт.
+    const size_t triads = n / TRIAD_LEN;
+    const auto first_byte = [&](int r) {
+        return (triads / num_processes * r + min<size_t>(r, triads % num_processes)) * TRIAD_LEN;
+    };
+    vector<int> counts(num_processes), displacements(num_processes);
+    for (int r = 0; r < num_processes; ++r) {
+        const size_t begin = first_byte(r), end = r + 1 == num_processes ? n : first_byte(r + 1);
+        if (2 * (end - begin) > INT_MAX || end > INT_MAX) {
+            if (rank == MASTER_RANK) {
+                cerr << "Error: text of " << n << " bytes is too large for " << num_processes << " processes" << endl;
+            }
+            return false;
+        }
+        counts[r] = (int)(end - begin);
+        displacements[r] = (int)begin;
+    }
+    const int local_n = counts[rank];
+
+    // Смещения и счётчики MPI_Gatherv для результата 2n байт тоже int
+    const bool gather_fits = 2 * n <= INT_MAX;
+    const bool use_mpi_io = !opts.output.empty() && (opts.mpi_io || !gather_fits);
+    if (!use_mpi_io && !gather_fits) {
+        if (rank == MASTER_RANK) {
+            cerr << "Error: result of " << 2 * n << " bytes is too large to gather; use --output=path" << endl;
+        }
+        return false;
+    }
+
+    phase_timer::PhaseTimer timer(opts.phases);
+    timer.start();
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    vector<char> local(local_n), local_result(2 * (size_t)local_n);
+    MPI_Scatterv(text.data(), counts.data(), displacements.data(), MPI_CHAR, local.data(), local_n, MPI_CHAR,
+        MASTER_RANK, MPI_COMM_WORLD);
+    double scatter_time = MPI_Wtime() - start;
+    timer.mark("scatter");
+
+    start = MPI_Wtime();
+    duplicate_triads_parallel(local.data(), local_n, local_result.data(), opts.threads);
+    double duplicate_time = MPI_Wtime() - start;
+    timer.mark("duplicate");
+
+    // Сборка результата: либо параллельная запись в файл, либо MPI_Gatherv на master
+    start = MPI_Wtime();
+    vector<char> result;
+    if (use_mpi_io) {
+        MPI_File file;
+        if (MPI_File_open(MPI_COMM_WORLD, opts.output.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+            &file) != MPI_SUCCESS) {
+            if (rank == MASTER_RANK) {
+                cerr << "Error: cannot open output file " << opts.output << endl;
+            }
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        MPI_File_set_size(file, (MPI_Offset)(2 * n));
+        MPI_File_write_at_all(file, (MPI_Offset)2 * displacements[rank], local_result.data(), 2 * local_n, MPI_CHAR,
+            MPI_STATUS_IGNORE);
+        MPI_File_close(&file);
+    }
+    else {
+        vector<int> result_counts(num_processes), result_displacements(num_processes);
+        for (int r = 0; r < num_processes; ++r) {
+            result_counts[r] = 2 * counts[r];
+            result_displacements[r] = 2 * displacements[r];
+        }
+        if (rank == MASTER_RANK) {
+            result.resize(2 * n);
+        }
+        MPI_Gatherv(local_result.data(), 2 * local_n, MPI_CHAR, result.data(), result_counts.data(),
+            result_displacements.data(), MPI_CHAR, MASTER_RANK, MPI_COMM_WORLD);
+        if (rank == MASTER_RANK && !opts.output.empty()) {
+            ofstream file(opts.output, ios::binary);
+            file.write(result.data(), (streamsize)result.size());
+        }
+    }
+    double assemble_time = MPI_Wtime() - start;
+    timer.mark("assemble");
+
+    // Время этапа — максимум по процессам
+    double times[3] = { scatter_time, duplicate_time, assemble_time };
+    MPI_Reduce(rank == MASTER_RANK ? MPI_IN_PLACE : times, times, 3, MPI_DOUBLE, MPI_MAX, MASTER_RANK, MPI_COMM_WORLD);
+    if (rank == MASTER_RANK) {
+        if (!result.empty() && n <= PRINT_LIMIT) {
+            cout << "Result: " << string(result.begin(), result.end()) << endl;
+        }
+        cout << "Distributed: " << n << " -> " << 2 * n << " bytes on " << num_processes << " processes x "
+            << opts.threads << " threads" << endl;
+        cout << "Scatter " << times[0] << " s, duplicate " << times[1] << " s, "
+            << (use_mpi_io ? "MPI-IO write " : "gather ") << times[2] << " s" << endl;
+    }
+    return true;
 }
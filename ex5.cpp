@@ -2,15 +2,153 @@
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <algorithm>
 #include <limits>
+#include <string_view>
+#include <string>
+#include <fstream> // Для записи максимумов строк в файл
+#include "phase_timer.h"
+#include <type_traits>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-inline void print_matrix(const vector<vector<int>>& matrix);
-inline void initialize_matrix_A(vector<vector<int>>& matrix, int n);
-inline void initialize_matrix_B(vector<vector<int>>& matrix, int n);
+// Тип элементов матриц и тип накопления сумм выбираются при сборке: -DEX5_ELEMENT_BITS=8
+// (int8 -> int32), 16 (int16 -> int32) или 32 (int32 -> int64, по умолчанию). Узкие элементы
+// в 2-4 раза уменьшают объём B, передаваемый по кольцу; суммы всегда шире элементов.
+#ifndef EX5_ELEMENT_BITS
+#define EX5_ELEMENT_BITS 32
+#endif
+#if EX5_ELEMENT_BITS == 8
+using Element = int8_t;
+using Accumulator = int32_t;
+#elif EX5_ELEMENT_BITS == 16
+using Element = int16_t;
+using Accumulator = int32_t;
+#elif EX5_ELEMENT_BITS == 32
+using Element = int32_t;
+using Accumulator = int64_t;
+#else
+#error "EX5_ELEMENT_BITS must be 8, 16 or 32"
+#endif
+
+// Тип MPI для целого типа T
+template <typename T>
+MPI_Datatype mpi_type() {
+    if constexpr (is_same_v<T, int8_t>) {
+        return MPI_INT8_T;
+    }
+    else if constexpr (is_same_v<T, int16_t>) {
+        return MPI_INT16_T;
+    }
+    else if constexpr (is_same_v<T, int32_t>) {
+        return MPI_INT32_T;
+    }
+    else {
+        return MPI_INT64_T;
+    }
+}
+
+// Плотная матрица в построчном порядке одним блоком памяти
+template <typename T>
+struct Matrix {
+    int rows = 0, cols = 0;
+    vector<T> data;
+
+    Matrix() = default;
+    Matrix(int num_rows, int num_cols) : rows(num_rows), cols(num_cols), data((size_t)num_rows * num_cols) {}
+
+    T* row(int i) { return data.data() + (size_t)i * cols; }
+    const T* row(int i) const { return data.data() + (size_t)i * cols; }
+    T& operator()(int i, int j) { return data[(size_t)i * cols + j]; }
+    T operator()(int i, int j) const { return data[(size_t)i * cols + j]; }
+};
+
+// Параметры запуска, полученные из командной строки
+struct Options {
+    bool bench_kernel = false; // Бенчмарк ядра строка x матрица против прежнего цикла
+    int max_n = 16384; // Наибольший размер матрицы в бенчмарке
+    bool bcast = false; // Рассылка B через MPI_Bcast вместо конвейерного кольца
+    size_t chunk = size_t(1) << 16; // Элементов B в порции конвейерного кольца (округляется до целых строк)
+    bool bench_broadcast = false; // Бенчмарк рассылки B: store-and-forward, конвейерное кольцо, MPI_Bcast
+    int bench_size = 2048; // Размер матрицы B в бенчмарке рассылки
+    int n = 0; // Размер матриц (0 — по числу процессов, как в исходной постановке)
+    bool summa = false; // Двумерная решётка процессов и алгоритм SUMMA вместо кольца
+    bool shared = false; // Одна копия B на узел в общей памяти (MPI_Win_allocate_shared)
+    bool random = false; // Случайные значения из [-100, 100] вместо формул исходной постановки
+    bool quiet = false; // Вместо вывода по строкам — только строка с наибольшим максимумом и время
+    bool provenance = false; // Выводить исходные данные каждого результата (O(n^3) строк вывода)
+    string output; // Файл максимумов строк (пусто — без записи)
+    bool binary = false; // Формат файла: n значений Accumulator подряд вместо CSV
+    bool phases = false; // Печать длительности фаз для bench_driver
+};
+
+// Максимумы строк [first_row, first_row + row_max.size()), вычисленные процессом
+struct RowMaxima {
+    int first_row = 0;
+    vector<Accumulator> row_max;
+};
+
+// Пара для MPI_MAXLOC: максимум строки и её номер (раскладка MPI_2INT или MPI_LONG_INT)
+struct RowArgmax {
+    Accumulator value;
+    int row;
+};
+
+// Значения матриц заданы формулами, поэтому каждый процесс строит свои блоки сам.
+// Исходные: A[i][j] = i + 1, B[i][j] = i + 1 + j * n. Случайные (--random) — хеш от
+// (матрица, i, j) в [-100, 100], одинаковый на всех процессах.
+struct MatrixValues {
+    int n = 0;
+    bool random = false;
+
+    long long a(int i, int j) const { return random ? hashed(0, i, j) : i + 1; }
+    long long b(int i, int j) const { return random ? hashed(1, i, j) : i + 1 + (long long)j * n; }
+    long long max_abs_a() const { return random ? 100 : n; }
+    long long max_abs_b() const { return random ? 100 : (long long)n * n; }
+
+    // splitmix64 от неперекрывающихся битов матрицы, строки и столбца
+    static long long hashed(uint64_t matrix, int i, int j) {
+        uint64_t x = matrix << 62 | (uint64_t)i << 31 | (uint64_t)j;
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return (long long)(x % 201) - 100;
+    }
+};
+
+const int PRINT_LIMIT = 32; // Матрицы выводятся только для малых n
+const int SUMMA_PANEL = 256; // Наибольшая ширина панели SUMMA
+
+inline Options parse_options(int argc, char** argv);
+inline bool values_fit(const MatrixValues& values);
+template <typename Value>
+void print_matrix(int n, Value value);
+inline void initialize_matrix_A(Matrix<Element>& block, int first_row, int first_col, const MatrixValues& values);
+inline void initialize_matrix_B(Matrix<Element>& block, int first_row, int first_col, const MatrixValues& values);
+inline RowMaxima ring_process(int rank, int size, const MatrixValues& values, const Options& opts);
+inline RowMaxima summa_process(int rank, int size, const MatrixValues& values);
+inline RowMaxima shared_process(int rank, int size, const MatrixValues& values, const Options& opts);
+inline vector<Accumulator> gather_row_max(int rank, int size, int n, const RowMaxima& local);
+inline RowArgmax reduce_argmax(const RowMaxima& local);
+inline void print_results(const MatrixValues& values, int size, const vector<Accumulator>& row_max, bool provenance);
+inline void write_row_max(const Options& opts, const vector<Accumulator>& row_max);
+template <typename E, typename Acc>
+void rows_times_matrix_max(const E* A, size_t lda, int rows, const E* B, int n, int m, Acc* row_max);
+template <typename E, typename Acc>
+void accumulate_rows_times_chunk(const E* A, size_t lda, int rows, const E* B_chunk, int first_row, int num_rows,
+    int m, Acc* sums);
+inline void bench_kernel(const Options& opts);
+inline void bench_broadcast(int rank, int size, const Options& opts);
+template <typename T, typename OnChunk>
+void ring_broadcast_pipelined(T* buffer, int rows, int cols, int chunk_rows, MPI_Comm ring_comm, int left,
+    int right, OnChunk on_chunk);
 
 int main(int argc, char* argv[]) {
     MPI_Init(&argc, &argv);
@@ -19,10 +157,247 @@ int main(int argc, char* argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    int n = size;  // Количество запущенных процессов
-    vector<vector<int>> A(n, vector<int>(n));
-    vector<vector<int>> B(n, vector<int>(n));
+    const Options opts = parse_options(argc, argv);
+
+    // Бенчмарк ядра выполняется только на процессе 0
+    if (opts.bench_kernel) {
+        if (rank == 0) {
+            bench_kernel(opts);
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Бенчмарк рассылки выполняется всеми процессами
+    if (opts.bench_broadcast) {
+        bench_broadcast(rank, size, opts);
+        MPI_Finalize();
+        return 0;
+    }
+
+    const int n = opts.n > 0 ? opts.n : size;  // По умолчанию — количество запущенных процессов
+    const MatrixValues values{ n, opts.random };
+
+    // Вместо молча переполненных сумм — ошибка до начала вычислений
+    if (!values_fit(values)) {
+        if (rank == 0) {
+            cerr << "n = " << n << " is too large for EX5_ELEMENT_BITS=" << EX5_ELEMENT_BITS
+                << ": matrix values or row sums would overflow" << endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (rank == 0 && !opts.quiet && n <= PRINT_LIMIT) {
+        cout << "Matrix A: " << endl;
+        print_matrix(n, [&](int i, int j) { return values.a(i, j); });
+        cout << endl;
+
+        cout << "Matrix B: " << endl;
+        print_matrix(n, [&](int i, int j) { return values.b(i, j); });
+        cout << endl;
+    }
+
+    // Максимумы строк произведения A * B; время вычисления — между барьерами, без вывода
+    phase_timer::PhaseTimer timer(opts.phases);
+    timer.start();
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+    const RowMaxima local = opts.summa ? summa_process(rank, size, values)
+        : opts.shared ? shared_process(rank, size, values, opts)
+        : ring_process(rank, size, values, opts);
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double elapsed = MPI_Wtime() - start;
+    timer.mark("compute");
+
+    // Все максимумы собираются на процессе 0, только если их нужно вывести или записать
+    if (!opts.quiet || !opts.output.empty()) {
+        const vector<Accumulator> row_max = gather_row_max(rank, size, n, local);
+        if (rank == 0 && !opts.quiet) {
+            print_results(values, size, row_max, opts.provenance);
+        }
+        if (rank == 0 && !opts.output.empty()) {
+            write_row_max(opts, row_max);
+        }
+    }
+    if (opts.quiet) {
+        const RowArgmax best = reduce_argmax(local);
+        if (rank == 0) {
+            cout << "ARGMAX: row " << best.row << ", max result = " << best.value << ", n = " << n << ", p = " << size
+                << ", time = " << elapsed << " s" << endl;
+        }
+    }
+    timer.mark("collect");
+
+    MPI_Finalize();
+    return 0;
+}
+
+// Разбор аргументов вида --n=N --summa --shared --bcast --chunk=ELEMENTS --bench-kernel --max-n=N --bench-broadcast
+// --bench-size=N --random --quiet --provenance --output=path --format=csv|binary --phases
+Options parse_options(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--bench-kernel") {
+            opts.bench_kernel = true;
+        }
+        else if (arg.starts_with("--max-n=")) {
+            opts.max_n = max(1, atoi(argv[i] + 8));
+        }
+        else if (arg.starts_with("--n=")) {
+            opts.n = max(1, atoi(argv[i] + 4));
+        }
+        else if (arg == "--summa") {
+            opts.summa = true;
+        }
+        else if (arg == "--shared") {
+            opts.shared = true;
+        }
+        else if (arg == "--bcast") {
+            opts.bcast = true;
+        }
+        else if (arg.starts_with("--chunk=")) {
+            opts.chunk = max<size_t>(1, strtoull(argv[i] + 8, nullptr, 10));
+        }
+        else if (arg == "--bench-broadcast") {
+            opts.bench_broadcast = true;
+        }
+        else if (arg.starts_with("--bench-size=")) {
+            opts.bench_size = max(1, atoi(argv[i] + 13));
+        }
+        else if (arg == "--random") {
+            opts.random = true;
+        }
+        else if (arg == "--quiet") {
+            opts.quiet = true;
+        }
+        else if (arg == "--provenance") {
+            opts.provenance = true;
+        }
+        else if (arg.starts_with("--output=")) {
+            opts.output = string(arg.substr(9));
+        }
+        else if (arg.starts_with("--format=")) {
+            opts.binary = arg.substr(9) == "binary";
+        }
+        else if (arg == "--phases") {
+            opts.phases = true;
+        }
+    }
+    return opts;
+}
+
+// Первая строка (столбец) части part из parts при разбиении n строк на почти равные блоки
+int block_start(int n, int parts, int part) {
+    return n / parts * part + min(part, n % parts);
+}
+
+// Часть, которой принадлежит строка (столбец) index
+int block_owner(int n, int parts, int index) {
+    int part = 0;
+    while (block_start(n, parts, part + 1) <= index) {
+        part++;
+    }
+    return part;
+}
+
+// Значения должны помещаться в Element, а сумма n произведений — в Accumulator
+bool values_fit(const MatrixValues& values) {
+    const long double max_sum = (long double)values.n * values.max_abs_a() * values.max_abs_b();
+    return values.max_abs_a() <= numeric_limits<Element>::max() && values.max_abs_b() <= numeric_limits<Element>::max()
+        && max_sum <= numeric_limits<Accumulator>::max();
+}
+
+// Тип MPI пары RowArgmax для MPI_MAXLOC
+MPI_Datatype argmax_type() {
+    static_assert(is_same_v<Accumulator, int> || is_same_v<Accumulator, long>, "MAXLOC pair needs int or long");
+    if constexpr (is_same_v<Accumulator, int>) {
+        return MPI_2INT;
+    }
+    else {
+        return MPI_LONG_INT;
+    }
+}
+
+// Максимумы всех строк на процессе 0: начала и размеры частей собираются через MPI_Gather,
+// сами значения — через MPI_Gatherv. Часть процесса может быть пустой (SUMMA).
+vector<Accumulator> gather_row_max(int rank, int size, int n, const RowMaxima& local) {
+    const int part[2] = { local.first_row, (int)local.row_max.size() };
+    vector<int> parts(rank == 0 ? 2 * size : 0);
+    MPI_Gather(part, 2, MPI_INT, parts.data(), 2, MPI_INT, 0, MPI_COMM_WORLD);
+
+    vector<int> counts(size), displacements(size);
+    for (int r = 0; rank == 0 && r < size; r++) {
+        displacements[r] = parts[2 * r];
+        counts[r] = parts[2 * r + 1];
+    }
+    vector<Accumulator> row_max(rank == 0 ? n : 0);
+    MPI_Gatherv(local.row_max.data(), part[1], mpi_type<Accumulator>(), row_max.data(), counts.data(),
+        displacements.data(), mpi_type<Accumulator>(), 0, MPI_COMM_WORLD);
+    return row_max;
+}
+
+// Строка с наибольшим максимумом на процессе 0 (MPI_MAXLOC: при равенстве — меньший номер).
+// Процесс без строк передаёт наименьшее значение с номером INT_MAX.
+RowArgmax reduce_argmax(const RowMaxima& local) {
+    RowArgmax best{ numeric_limits<Accumulator>::min(), numeric_limits<int>::max() };
+    for (size_t i = 0; i < local.row_max.size(); i++) {
+        if (local.row_max[i] > best.value || best.row == numeric_limits<int>::max()) {
+            best = { local.row_max[i], local.first_row + (int)i };
+        }
+    }
+    RowArgmax result{};
+    MPI_Reduce(&best, &result, 1, argmax_type(), MPI_MAXLOC, 0, MPI_COMM_WORLD);
+    return result;
+}
+
+// Запись максимумов строк: CSV "row,max" или n значений Accumulator подряд в порядке строк
+void write_row_max(const Options& opts, const vector<Accumulator>& row_max) {
+    ofstream file(opts.output, opts.binary ? ios::binary : ios::out);
+    if (!file) {
+        cerr << "Error: cannot open output file " << opts.output << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (opts.binary) {
+        file.write(reinterpret_cast<const char*>(row_max.data()), (streamsize)(row_max.size() * sizeof(Accumulator)));
+        return;
+    }
+    file << "row,max\n";
+    for (size_t i = 0; i < row_max.size(); i++) {
+        file << i << "," << row_max[i] << "\n";
+    }
+}
+
+// Результат процесса 0: максимум каждой строки и, если запрошено (--provenance), исходные данные
+void print_results(const MatrixValues& values, int size, const vector<Accumulator>& row_max, bool provenance) {
+    const int n = values.n;
+    for (int i = 0; i < n; i++) {
+        // При n, равном числу процессов, строка i — это процесс i, как в исходной постановке
+        cout << (n == size ? "RANK[" : "ROW[") << i << "]: Max result = " << row_max[i] << endl;
+        if (!provenance) {
+            continue;
+        }
+        cout << "It was calculated with the values:\n";
+        for (int j = 0; j < n; j++) {
+            cout << "A[" << i << "]: ";
+            for (int k = 0; k < n; k++) {
+                cout << values.a(i, k) << " ";
+            }
+            cout << "and B[" << j << "]: ";
+            for (int k = 0; k < n; k++) {
+                cout << values.b(k, j) << " ";
+            }
+            cout << endl;
+        }
+        cout << endl;
+    }
+}
 
+// Кольцо процессов: A распределена блоками строк, B рассылается по кольцу целиком
+// (конвейерно или через MPI_Bcast). Возвращает максимумы строк своего блока.
+RowMaxima ring_process(int rank, int size, const MatrixValues& values, const Options& opts) {
+    const int n = values.n;
     // Создание виртуальной топологии "кольцо"
     MPI_Comm ring_comm;
     int dims[1] = { size };
@@ -32,112 +407,671 @@ int main(int argc, char* argv[]) {
     int left, right;
     MPI_Cart_shift(ring_comm, 0, 1, &left, &right);
 
-    initialize_matrix_A(A, n);
+    // Каждый процесс строит только свой блок строк A
+    const int first_row = block_start(n, size, rank);
+    const int rows = block_start(n, size, rank + 1) - first_row;
+    Matrix<Element> A(rows, n);
+    initialize_matrix_A(A, first_row, 0, values);
+    Matrix<Element> B(n, n);
     if (rank == 0) {
-        initialize_matrix_B(B, n);
+        initialize_matrix_B(B, 0, 0, values);
     }
 
-    if (rank == 0) {
-        cout << "Matrix A: " << endl;
-        print_matrix(A);
-        cout << endl;
+    // Передача матрицы B и вычисление максимумов по столбцам произведений строк A на B
+    vector<Accumulator> local_max(rows);
+    if (opts.bcast) {
+        MPI_Bcast(B.data.data(), n * n, mpi_type<Element>(), 0, ring_comm);
+        rows_times_matrix_max(A.data.data(), A.cols, rows, B.data.data(), n, n, local_max.data());
+    }
+    else {
+        // Конвейерное кольцо: пока принимается следующая порция строк B, полученная порция
+        // пересылается дальше. Максимум по столбцам требует всех строк B, поэтому ядро
+        // rows_times_matrix_max запускается один раз по приходу последней порции — пока
+        // последние пересылки ещё в полёте, и без буфера сумм rows x n
+        const int chunk_rows = (int)clamp<size_t>(opts.chunk / n, 1, n);
+        ring_broadcast_pipelined(B.data.data(), n, n, chunk_rows, ring_comm, left, right,
+            [&](int chunk_first_row, int num_rows) {
+                if (chunk_first_row + num_rows == n) {
+                    rows_times_matrix_max(A.data.data(), A.cols, rows, B.data.data(), n, n, local_max.data());
+                }
+            });
+    }
 
-        cout << "Matrix B: " << endl;
-        print_matrix(B);
-        cout << endl;
+    MPI_Comm_free(&ring_comm);
+    return { first_row, local_max };
+}
+
+// Кольцо узлов: процессы одного узла (MPI_Comm_split_type с MPI_COMM_TYPE_SHARED) читают
+// одну копию B из общего окна MPI_Win_allocate_shared, которое выделяет ведущий процесс узла.
+// B рассылается только между ведущими (конвейерно или через MPI_Bcast) — между узлами она
+// проходит один раз на узел, а память под B сокращается в число процессов на узле раз.
+RowMaxima shared_process(int rank, int size, const MatrixValues& values, const Options& opts) {
+    const int n = values.n;
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+
+    // Ведущие процессы узлов; ключ rank делает процесс 0 ведущим с номером 0
+    MPI_Comm leader_comm;
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+
+    // Память окна есть только у ведущего; остальные получают указатель на неё
+    const MPI_Aint B_bytes = node_rank == 0 ? (MPI_Aint)n * n * sizeof(Element) : 0;
+    Element* B = nullptr;
+    MPI_Win B_win;
+    MPI_Win_allocate_shared(B_bytes, sizeof(Element), MPI_INFO_NULL, node_comm, &B, &B_win);
+    if (node_rank != 0) {
+        MPI_Aint segment_size;
+        int disp_unit;
+        MPI_Win_shared_query(B_win, 0, &segment_size, &disp_unit, &B);
     }
 
-    // Передача матрицы B по кольцу
-    vector<int> flat_B(n * n);
-    if (rank == 0) {
-        for (int i = 0; i < n; i++) {
-            for (int j = 0; j < n; j++) {
-                flat_B[i * n + j] = B[i][j];
+    const int first_row = block_start(n, size, rank);
+    const int rows = block_start(n, size, rank + 1) - first_row;
+    Matrix<Element> A(rows, n);
+    initialize_matrix_A(A, first_row, 0, values);
+
+    MPI_Win_fence(MPI_MODE_NOPRECEDE, B_win);
+    if (leader_comm != MPI_COMM_NULL) {
+        int leader_rank, leaders;
+        MPI_Comm_rank(leader_comm, &leader_rank);
+        MPI_Comm_size(leader_comm, &leaders);
+        if (leader_rank == 0) {
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    B[(size_t)i * n + j] = (Element)values.b(i, j);
+                }
+            }
+        }
+        if (opts.bcast) {
+            MPI_Bcast(B, n * n, mpi_type<Element>(), 0, leader_comm);
+        }
+        else {
+            MPI_Comm ring_comm;
+            int dims[1] = { leaders };
+            int periods[1] = { 1 };
+            MPI_Cart_create(leader_comm, 1, dims, periods, 0, &ring_comm);
+            int left, right;
+            MPI_Cart_shift(ring_comm, 0, 1, &left, &right);
+            const int chunk_rows = (int)clamp<size_t>(opts.chunk / n, 1, n);
+            ring_broadcast_pipelined(B, n, n, chunk_rows, ring_comm, left, right, [](int, int) {});
+            MPI_Comm_free(&ring_comm);
+        }
+        MPI_Comm_free(&leader_comm);
+    }
+    // Ведущие записывали B в окно (заполнение и приём), поэтому MPI_MODE_NOSTORE здесь
+    // неверен: fence должен синхронизировать память. После него B видна всем процессам
+    // узла и дальше только читается
+    MPI_Win_fence(MPI_MODE_NOSUCCEED | MPI_MODE_NOPUT, B_win);
+
+    vector<Accumulator> local_max(rows);
+    rows_times_matrix_max(A.data.data(), A.cols, rows, B, n, n, local_max.data());
+
+    MPI_Win_free(&B_win);
+    MPI_Comm_free(&node_comm);
+    return { first_row, local_max };
+}
+
+// SUMMA на двумерной решётке dims[0] x dims[1] (MPI_Cart_create с 2 измерениями).
+// Процесс (i, j) хранит блоки (i, j) матриц A, B и сумм C: строки — блок i из dims[0],
+// столбцы — блок j из dims[1]. На каждом шаге панель столбцов A рассылается вдоль строки
+// решётки, панель строк B — вдоль столбца, и процесс добавляет их произведение к своему
+// блоку C. Ни A, ни B целиком не хранятся нигде: память процесса O(n^2 / p).
+RowMaxima summa_process(int rank, int size, const MatrixValues& values) {
+    const int n = values.n;
+    int dims[2] = { 0, 0 };
+    MPI_Dims_create(size, 2, dims);
+    int periods[2] = { 0, 0 };
+    MPI_Comm grid_comm;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &grid_comm);
+    int coords[2];
+    MPI_Cart_coords(grid_comm, rank, 2, coords);
+
+    // Подкоммуникаторы строки и столбца решётки; ранг в них — координата вдоль измерения
+    MPI_Comm row_comm, col_comm;
+    int keep_cols[2] = { 0, 1 };
+    int keep_rows[2] = { 1, 0 };
+    MPI_Cart_sub(grid_comm, keep_cols, &row_comm);
+    MPI_Cart_sub(grid_comm, keep_rows, &col_comm);
+
+    const int first_row = block_start(n, dims[0], coords[0]);
+    const int rows = block_start(n, dims[0], coords[0] + 1) - first_row;
+    const int first_col = block_start(n, dims[1], coords[1]);
+    const int cols = block_start(n, dims[1], coords[1] + 1) - first_col;
+    Matrix<Element> A(rows, cols), B(rows, cols);
+    Matrix<Accumulator> C(rows, cols);
+    initialize_matrix_A(A, first_row, first_col, values);
+    initialize_matrix_B(B, first_row, first_col, values);
+
+    // Панель — общий отрезок [k, end) разбиения столбцов A (по dims[1]) и строк B (по dims[0])
+    vector<Element> A_panel((size_t)rows * SUMMA_PANEL), B_panel((size_t)SUMMA_PANEL * cols);
+    for (int k = 0; k < n;) {
+        const int A_owner = block_owner(n, dims[1], k);
+        const int B_owner = block_owner(n, dims[0], k);
+        const int end = min({ k + SUMMA_PANEL, block_start(n, dims[1], A_owner + 1),
+            block_start(n, dims[0], B_owner + 1) });
+        const int width = end - k;
+
+        if (coords[1] == A_owner) {
+            for (int r = 0; r < rows; r++) {
+                copy(A.row(r) + (k - first_col), A.row(r) + (k - first_col) + width, A_panel.data() + (size_t)r * width);
             }
         }
+        MPI_Bcast(A_panel.data(), rows * width, mpi_type<Element>(), A_owner, row_comm);
 
-        MPI_Send(flat_B.data(), n * n, MPI_INT, right, 0, ring_comm);
+        // Строки панели B у владельца лежат подряд и рассылаются прямо из блока
+        Element* B_rows = coords[0] == B_owner ? B.row(k - first_row) : B_panel.data();
+        MPI_Bcast(B_rows, width * cols, mpi_type<Element>(), B_owner, col_comm);
+
+        accumulate_rows_times_chunk(A_panel.data(), width, rows, B_rows, 0, width, cols, C.data.data());
+        k = end;
     }
-    else {
-        MPI_Recv(flat_B.data(), n * n, MPI_INT, left, 0, ring_comm, MPI_STATUS_IGNORE);
-        if (rank != n - 1) {
-            MPI_Send(flat_B.data(), n * n, MPI_INT, right, 0, ring_comm);
+
+    // Максимум строки: сначала по своим столбцам, затем вдоль строки решётки в столбец 0;
+    // максимумы строк блока возвращают только процессы столбца 0
+    vector<Accumulator> local_max(rows, numeric_limits<Accumulator>::min()), block_max(rows);
+    for (int r = 0; r < rows; r++) {
+        for (int j = 0; j < cols; j++) {
+            local_max[r] = max(local_max[r], C(r, j));
         }
     }
+    MPI_Reduce(local_max.data(), block_max.data(), rows, mpi_type<Accumulator>(), MPI_MAX, 0, row_comm);
 
-    // Вычисление результата
-    vector<int> row = A[rank];
-    int max_result = numeric_limits<int>::min();
+    MPI_Comm_free(&row_comm);
+    MPI_Comm_free(&col_comm);
+    MPI_Comm_free(&grid_comm);
+    if (coords[1] != 0) {
+        block_max.clear();
+    }
+    return { first_row, block_max };
+}
 
-    for (int j = 0; j < n; j++) {
-        int sum = 0;
-        for (int k = 0; k < n; k++) {
-            sum += row[k] * flat_B[k * n + j];
+// Вывод матрицы n x n, заданной формулой value(i, j)
+template <typename Value>
+void print_matrix(int n, Value value) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            cout << value(i, j) << " ";
         }
-        max_result = max(max_result, sum);
+        cout << endl;
     }
+}
 
-    if (rank == 0) {
-        // Сбор результатов от всех процессов
-        vector<int> all_results(n);
-        all_results[0] = max_result;  // Результат от процесса 0
-
-        // Получение результатов от остальных процессов
-        for (int i = 1; i < n; i++) {
-            MPI_Recv(&all_results[i], 1, MPI_INT, i, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
-
-        // Вывод результатов
-        for (int i = 0; i < n; i++) {
-            cout << "RANK[" << i << "]: Max result = " << all_results[i] << endl;
-            cout << "It was calculated with the values:\n";
-            for (int j = 0; j < n; j++) {
-                cout << "A[" << i << "]: ";
-                for (int num : A[i]) {
-                    cout << num << " ";
-                }
-                cout << "and B[" << j << "]: ";
-                for (int k = 0; k < n; k++) {
-                    cout << B[k][j] << " ";
-                }
-                cout << endl;
+// Конвейерная рассылка матрицы rows x cols от процесса 0 по кольцу порциями по chunk_rows
+// строк. Процесс держит в полёте приём двух следующих порций, а полученную порцию сразу
+// пересылает правому соседу (MPI_Isend) и передаёт в on_chunk(first_row, num_rows).
+// Время рассылки — O((p + число порций) * порция) вместо O(p * rows * cols).
+// Все порции идут с одним тегом: сообщения одной пары процессов в ring_comm не обгоняют
+// друг друга, а приёмы выставляются по порядку, так что номер порции в теге не нужен
+// (и при num_chunks > 32767 мог бы превысить гарантированный стандартом MPI_TAG_UB).
+template <typename T, typename OnChunk>
+void ring_broadcast_pipelined(T* buffer, int rows, int cols, int chunk_rows, MPI_Comm ring_comm, int left,
+    int right, OnChunk on_chunk) {
+    const int RECEIVES_IN_FLIGHT = 2;
+    const int TAG_CHUNK = 0;
+    int rank, size;
+    MPI_Comm_rank(ring_comm, &rank);
+    MPI_Comm_size(ring_comm, &size);
+    const bool forward = rank != size - 1; // Последний процесс кольца никому не пересылает
+    const int num_chunks = (rows + chunk_rows - 1) / chunk_rows;
+    auto first_row = [&](int c) { return c * chunk_rows; };
+    auto chunk_count = [&](int c) { return (min(rows, first_row(c) + chunk_rows) - first_row(c)) * cols; };
+    auto chunk_data = [&](int c) { return buffer + (size_t)first_row(c) * cols; };
+
+    vector<MPI_Request> sends;
+    sends.reserve(forward ? num_chunks : 0);
+    MPI_Request receives[RECEIVES_IN_FLIGHT] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    auto post_receive = [&](int c) {
+        if (rank != 0 && c < num_chunks) {
+            MPI_Irecv(chunk_data(c), chunk_count(c), mpi_type<T>(), left, TAG_CHUNK, ring_comm,
+                &receives[c % RECEIVES_IN_FLIGHT]);
+        }
+    };
+    for (int c = 0; c < RECEIVES_IN_FLIGHT; c++) {
+        post_receive(c);
+    }
+
+    for (int c = 0; c < num_chunks; c++) {
+        if (rank != 0) {
+            MPI_Wait(&receives[c % RECEIVES_IN_FLIGHT], MPI_STATUS_IGNORE);
+        }
+        if (forward) {
+            sends.emplace_back();
+            MPI_Isend(chunk_data(c), chunk_count(c), mpi_type<T>(), right, TAG_CHUNK, ring_comm, &sends.back());
+        }
+        post_receive(c + RECEIVES_IN_FLIGHT);
+        on_chunk(first_row(c), chunk_count(c) / cols);
+    }
+    MPI_Waitall((int)sends.size(), sends.data(), MPI_STATUSES_IGNORE);
+}
+
+// Инициализация блока матрицы A, начинающегося в строке first_row и столбце first_col
+void initialize_matrix_A(Matrix<Element>& block, int first_row, int first_col, const MatrixValues& values) {
+    for (int i = 0; i < block.rows; i++) {
+        for (int j = 0; j < block.cols; j++) {
+            block(i, j) = (Element)values.a(first_row + i, first_col + j);
+        }
+    }
+}
+
+// Инициализация блока матрицы B
+void initialize_matrix_B(Matrix<Element>& block, int first_row, int first_col, const MatrixValues& values) {
+    for (int i = 0; i < block.rows; i++) {
+        for (int j = 0; j < block.cols; j++) {
+            block(i, j) = (Element)values.b(first_row + i, first_col + j);
+        }
+    }
+}
+
+// acc += a * b по полосам, где оба множителя — расширенные до Acc значения E. Для int32 -> int64
+// на AVX2 и AVX-512 это одна vpmuldq (32 x 32 -> 64) вместо эмулируемого 64-битного умножения.
+// Функция всегда встраивается в ядра с нужным target, поэтому предупреждение об ABI векторов
+// к ней не относится.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+template <typename E, typename Acc, size_t Bytes, typename Vector>
+__attribute__((always_inline)) inline void widening_multiply_add(Vector& acc, const Vector& a, const Vector& b) {
+    constexpr bool words_to_quads = sizeof(E) == 4 && sizeof(Acc) == 8;
+#if defined(__x86_64__)
+    if constexpr (words_to_quads && Bytes == 64) {
+        typedef int Words __attribute__((vector_size(64)));
+        typedef long long Quads __attribute__((vector_size(64)));
+        acc += (Vector)__builtin_ia32_pmuldq512_mask((Words)a, (Words)b, Quads{}, (unsigned char)-1);
+    }
+    else if constexpr (words_to_quads && Bytes == 32) {
+        typedef int Words __attribute__((vector_size(32)));
+        acc += (Vector)__builtin_ia32_pmuldq256((Words)a, (Words)b);
+    }
+    else {
+        acc += a * b;
+    }
+#else
+    acc += a * b;
+#endif
+}
+#pragma GCC diagnostic pop
+
+// Максимумы по столбцам произведения R строк A на панель B из n строк по 2 * LANES
+// элементов (шаг строк ldb). Элементы E при загрузке расширяются до типа сумм Acc; для каждой
+// строки A панель накапливается в двух векторных регистрах, а каждая загрузка B используется
+// R строками.
+template <typename E, typename Acc, size_t Bytes, int R>
+__attribute__((always_inline)) inline void tile_max(const E* A, size_t lda, const E* tile, int n, int ldb,
+    Acc* row_max) {
+    typedef Acc Vector __attribute__((vector_size(Bytes)));
+    constexpr int LANES = Bytes / sizeof(Acc);
+    typedef E Narrow __attribute__((vector_size(LANES * sizeof(E))));
+    Vector acc[R][2] = {};
+    for (int k = 0; k < n; k++) {
+        Narrow b[2];
+        memcpy(&b[0], tile + (size_t)k * ldb, sizeof(Narrow));
+        memcpy(&b[1], tile + (size_t)k * ldb + LANES, sizeof(Narrow));
+        const Vector wide[2] = { __builtin_convertvector(b[0], Vector), __builtin_convertvector(b[1], Vector) };
+        for (int r = 0; r < R; r++) {
+            const Vector a = Vector{} + (Acc)A[r * lda + k];
+            widening_multiply_add<E, Acc, Bytes>(acc[r][0], a, wide[0]);
+            widening_multiply_add<E, Acc, Bytes>(acc[r][1], a, wide[1]);
+        }
+    }
+    for (int r = 0; r < R; r++) {
+        const Vector both = acc[r][0] > acc[r][1] ? acc[r][0] : acc[r][1];
+        for (int lane = 0; lane < LANES; lane++) {
+            row_max[r] = max(row_max[r], both[lane]);
+        }
+    }
+}
+
+// Столбцы [j0, m) — скалярно, в беззнаковой арифметике типа сумм
+template <typename E, typename Acc>
+__attribute__((always_inline)) inline void columns_max_scalar(const E* A, size_t lda, int rows, const E* B, int n,
+    int m, int j0, Acc* row_max) {
+    using Unsigned = make_unsigned_t<Acc>;
+    for (int r = 0; r < rows; r++) {
+        for (int j = j0; j < m; j++) {
+            Unsigned sum = 0;
+            for (int k = 0; k < n; k++) {
+                sum += (Unsigned)(Acc)A[r * lda + k] * (Unsigned)(Acc)B[(size_t)k * m + j];
             }
-            cout << endl;
+            row_max[r] = max(row_max[r], (Acc)sum);
         }
     }
+}
+
+// Максимум по столбцам произведения каждой из rows строк A (шаг lda) на B (n x m),
+// без вектора произведений: плитки столбцов по 2 * LANES, внутри плитки — группы по 4
+// строки, чтобы панель B плитки переиспользовалась из кэша всеми строками.
+template <typename E, typename Acc, size_t Bytes>
+__attribute__((always_inline)) inline void rows_times_matrix_max_block(const E* A, size_t lda, int rows, const E* B,
+    int n, int m, Acc* row_max) {
+    constexpr int TILE = 2 * Bytes / sizeof(Acc);
+    fill(row_max, row_max + rows, numeric_limits<Acc>::min());
+
+    // При нескольких группах строк панель B плитки (n x TILE) копируется подряд: строки
+    // матрицы B отстоят на m элементов, и при больших m каждая попадает на свою страницу
+    const bool pack = rows > 4;
+    vector<E> panel(pack ? (size_t)n * TILE : 0);
+    int j0 = 0;
+    for (; j0 + TILE <= m; j0 += TILE) {
+        const E* tile = B + j0;
+        int ldb = m;
+        if (pack) {
+            for (int k = 0; k < n; k++) {
+                memcpy(panel.data() + (size_t)k * TILE, B + (size_t)k * m + j0, TILE * sizeof(E));
+            }
+            tile = panel.data();
+            ldb = TILE;
+        }
+        int r = 0;
+        for (; r + 4 <= rows; r += 4) {
+            tile_max<E, Acc, Bytes, 4>(A + r * lda, lda, tile, n, ldb, row_max + r);
+        }
+        for (; r < rows; r++) {
+            tile_max<E, Acc, Bytes, 1>(A + r * lda, lda, tile, n, ldb, row_max + r);
+        }
+    }
+    columns_max_scalar(A, lda, rows, B, n, m, j0, row_max);
+}
+
+#if defined(__x86_64__)
+// Накопление попарных произведений int16 в int32: acc += b[2l] * a[2l] + b[2l + 1] * a[2l + 1]
+// в каждой полосе l (vpmaddwd + vpaddd на AVX2, одна vpdpwssd на AVX-512 VNNI). Функция всегда
+// встраивается в ядра с нужным target, поэтому предупреждение об ABI векторов к ней не относится.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+template <size_t Bytes, typename Vector>
+__attribute__((always_inline)) inline void madd_pairs(Vector& acc, const Vector& b, const Vector& a) {
+    typedef short Halves __attribute__((vector_size(32)));
+    if constexpr (Bytes == 64) {
+        acc = __builtin_ia32_vpdpwssd_v16si(acc, b, a);
+    }
     else {
-        // Отправка результата мастеру
-        MPI_Send(&max_result, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
+        acc += __builtin_ia32_pmaddwd256((Halves)b, (Halves)a);
     }
+}
+#pragma GCC diagnostic pop
 
-    MPI_Comm_free(&ring_comm);
-    MPI_Finalize();
-    return 0;
+// То же, что tile_max, для элементов int8/int16 и сумм int32. Строки k и k + 1 панели B
+// чередуются в ней парами int16 (панель из ceil(n / 2) пар по 2 * TILE значений), а пара
+// a[k], a[k + 1] размножается по всем полосам, так что одна инструкция умножает и складывает
+// две строки B сразу. Acc — всегда int32_t.
+template <typename E, typename Acc, size_t Bytes, int R>
+__attribute__((always_inline)) inline void tile_max_pairs(const E* A, size_t lda, const int16_t* panel, int n,
+    Acc* row_max) {
+    typedef Acc Vector __attribute__((vector_size(Bytes)));
+    constexpr int LANES = Bytes / sizeof(Acc);
+    Vector acc[R][2] = {};
+    for (int k = 0; k < n; k += 2) {
+        Vector b[2];
+        memcpy(&b[0], panel + (size_t)k * 2 * LANES, Bytes);
+        memcpy(&b[1], panel + (size_t)k * 2 * LANES + 2 * LANES, Bytes);
+        const bool odd_tail = k + 1 == n;
+        for (int r = 0; r < R; r++) {
+            const uint16_t a_low = (uint16_t)A[r * lda + k];
+            const uint16_t a_high = odd_tail ? 0 : (uint16_t)A[r * lda + k + 1];
+            const Vector a = Vector{} + (Acc)(a_low | (uint32_t)a_high << 16);
+            madd_pairs<Bytes>(acc[r][0], b[0], a);
+            madd_pairs<Bytes>(acc[r][1], b[1], a);
+        }
+    }
+    for (int r = 0; r < R; r++) {
+        const Vector both = acc[r][0] > acc[r][1] ? acc[r][0] : acc[r][1];
+        for (int lane = 0; lane < LANES; lane++) {
+            row_max[r] = max(row_max[r], both[lane]);
+        }
+    }
 }
 
-void print_matrix(const vector<vector<int>>& matrix) {
-    for (const auto& row : matrix) {
-        for (int val : row) {
-            cout << val << " ";
+template <typename E, size_t Bytes>
+__attribute__((always_inline)) inline void rows_times_matrix_max_pairs(const E* A, size_t lda, int rows, const E* B,
+    int n, int m, int32_t* row_max) {
+    constexpr int TILE = 2 * Bytes / sizeof(int32_t);
+    fill(row_max, row_max + rows, numeric_limits<int32_t>::min());
+
+    // Панель перепаковывается для каждой плитки; при нечётном n вторая строка последней
+    // пары остаётся нулевой
+    vector<int16_t> panel((size_t)(n + 1) / 2 * 2 * TILE);
+    int j0 = 0;
+    for (; j0 + TILE <= m; j0 += TILE) {
+        for (int k = 0; k < n; k++) {
+            const E* b = B + (size_t)k * m + j0;
+            int16_t* pairs = panel.data() + (size_t)(k / 2) * 2 * TILE + k % 2;
+            for (int j = 0; j < TILE; j++) {
+                pairs[2 * j] = b[j];
+            }
+        }
+        int r = 0;
+        for (; r + 4 <= rows; r += 4) {
+            tile_max_pairs<E, int32_t, Bytes, 4>(A + r * lda, lda, panel.data(), n, row_max + r);
+        }
+        for (; r < rows; r++) {
+            tile_max_pairs<E, int32_t, Bytes, 1>(A + r * lda, lda, panel.data(), n, row_max + r);
         }
-        cout << endl;
     }
+    columns_max_scalar(A, lda, rows, B, n, m, j0, row_max);
 }
+#endif
 
-// Инициализация матрицы A
-void initialize_matrix_A(vector<vector<int>>& matrix, int n) {
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            matrix[i][j] = i + 1;  // Заполнение матрицы значениями i+1
+template <typename E, typename Acc>
+using RowsKernel = void (*)(const E*, size_t, int, const E*, int, int, Acc*);
+
+#if defined(__x86_64__)
+template <typename E>
+__attribute__((target("avx512f,avx512vnni"))) void rows_times_matrix_max_vnni(const E* A, size_t lda, int rows,
+    const E* B, int n, int m, int32_t* row_max) {
+    rows_times_matrix_max_pairs<E, 64>(A, lda, rows, B, n, m, row_max);
+}
+
+template <typename E>
+__attribute__((target("avx2"))) void rows_times_matrix_max_madd(const E* A, size_t lda, int rows, const E* B, int n,
+    int m, int32_t* row_max) {
+    rows_times_matrix_max_pairs<E, 32>(A, lda, rows, B, n, m, row_max);
+}
+
+template <typename E, typename Acc>
+__attribute__((target("avx512f"))) void rows_times_matrix_max_avx512(const E* A, size_t lda, int rows, const E* B,
+    int n, int m, Acc* row_max) {
+    rows_times_matrix_max_block<E, Acc, 64>(A, lda, rows, B, n, m, row_max);
+}
+
+template <typename E, typename Acc>
+__attribute__((target("avx2"))) void rows_times_matrix_max_avx2(const E* A, size_t lda, int rows, const E* B, int n,
+    int m, Acc* row_max) {
+    rows_times_matrix_max_block<E, Acc, 32>(A, lda, rows, B, n, m, row_max);
+}
+#endif
+
+template <typename E, typename Acc>
+void rows_times_matrix_max_generic(const E* A, size_t lda, int rows, const E* B, int n, int m, Acc* row_max) {
+    rows_times_matrix_max_block<E, Acc, 16>(A, lda, rows, B, n, m, row_max);
+}
+
+// Ядро строки x матрица с максимумом по столбцам для элементов E и сумм Acc; самое широкое
+// из поддерживаемых процессором выбирается один раз. Для int8/int16 -> int32 предпочтительны
+// ядра на попарных произведениях (VNNI, затем pmaddwd).
+template <typename E, typename Acc>
+void rows_times_matrix_max(const E* A, size_t lda, int rows, const E* B, int n, int m, Acc* row_max) {
+    using Kernel = RowsKernel<E, Acc>;
+    static const Kernel kernel = [] {
+#if defined(__x86_64__)
+        if constexpr (sizeof(E) <= sizeof(int16_t) && is_same_v<Acc, int32_t>) {
+            if (__builtin_cpu_supports("avx512vnni")) return static_cast<Kernel>(rows_times_matrix_max_vnni<E>);
+            if (__builtin_cpu_supports("avx2")) return static_cast<Kernel>(rows_times_matrix_max_madd<E>);
+        }
+        if (__builtin_cpu_supports("avx512f")) return static_cast<Kernel>(rows_times_matrix_max_avx512<E, Acc>);
+        if (__builtin_cpu_supports("avx2")) return static_cast<Kernel>(rows_times_matrix_max_avx2<E, Acc>);
+#endif
+        return static_cast<Kernel>(rows_times_matrix_max_generic<E, Acc>);
+    }();
+    kernel(A, lda, rows, B, n, m, row_max);
+}
+
+// Добавляет к суммам sums (rows x m) вклад строк [first_row, first_row + num_rows) матрицы B,
+// заданных указателем B_chunk. Используется конвейерной рассылкой, когда B приходит порциями
+// и максимум можно взять только после последней порции. Арифметика по модулю, как в ядре.
+template <typename E, typename Acc>
+void accumulate_rows_times_chunk(const E* A, size_t lda, int rows, const E* B_chunk, int first_row, int num_rows,
+    int m, Acc* sums) {
+    using Unsigned = make_unsigned_t<Acc>;
+    for (int r = 0; r < rows; r++) {
+        Unsigned* row_sums = reinterpret_cast<Unsigned*>(sums + (size_t)r * m);
+        for (int k = 0; k < num_rows; k++) {
+            const Unsigned a = (Unsigned)(Acc)A[r * lda + first_row + k];
+            const E* b = B_chunk + (size_t)k * m;
+            for (int j = 0; j < m; j++) {
+                row_sums[j] += a * (Unsigned)(Acc)b[j];
+            }
         }
     }
 }
 
-// Инициализация матрицы B
-void initialize_matrix_B(vector<vector<int>>& matrix, int n) {
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            matrix[i][j] = i + 1 + j * n;
+// Прежний цикл: столбцы B обходятся с шагом n (эталон для бенчмарка)
+template <typename E, typename Acc>
+Acc row_times_matrix_max_loop(const E* row, const E* flat_B, int n) {
+    Acc max_result = numeric_limits<Acc>::min();
+    for (int j = 0; j < n; j++) {
+        Acc sum = 0;
+        for (int k = 0; k < n; k++) {
+            sum += (Acc)row[k] * flat_B[k * n + j];
+        }
+        max_result = max(max_result, sum);
+    }
+    return max_result;
+}
+
+// Скорость (млрд умножений-сложений в секунду) прежнего цикла и ядра для одного размера.
+// Значения из [-100, 100], чтобы суммы не переполнялись и результаты можно было сравнить.
+template <typename E, typename Acc>
+void bench_kernel_size(const char* name, int n) {
+    // Число строк и повторов подобрано так, чтобы замер шёл не слишком долго
+    const double work = (double)n * n;
+    const int loop_rows = (int)clamp<double>((1 << 24) / work, 1, n);
+    const int kernel_rows = (int)clamp<double>((1 << 28) / work, min(4, n), n);
+    const int reps = (int)max<double>(1, (1 << 28) / (work * kernel_rows));
+
+    Matrix<E> A(max(loop_rows, kernel_rows), n), B(n, n);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    auto next = [&] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (E)((int)(state % 201) - 100);
+    };
+    for (E& value : A.data) value = next();
+    for (E& value : B.data) value = next();
+
+    vector<Acc> loop_max(loop_rows), kernel_max(kernel_rows);
+    double start = MPI_Wtime();
+    for (int r = 0; r < loop_rows; r++) {
+        loop_max[r] = row_times_matrix_max_loop<E, Acc>(A.row(r), B.data.data(), n);
+    }
+    const double loop_time = MPI_Wtime() - start;
+
+    start = MPI_Wtime();
+    for (int rep = 0; rep < reps; rep++) {
+        rows_times_matrix_max(A.data.data(), A.cols, kernel_rows, B.data.data(), n, n, kernel_max.data());
+    }
+    const double kernel_time = (MPI_Wtime() - start) / reps;
+
+    const double loop_rate = loop_rows * work / loop_time / 1e9;
+    const double kernel_rate = kernel_rows * work / kernel_time / 1e9;
+    const bool match = equal(loop_max.begin(), loop_max.end(), kernel_max.begin());
+    cout << n << "\t" << name << "\t" << loop_rate << "\t" << kernel_rate << "\t" << kernel_rate / loop_rate << "\t"
+        << (match ? "yes" : "NO") << endl;
+}
+
+// Бенчмарк для n = 64, 128, ..., max_n по всем сочетаниям элементов и сумм, которые можно
+// выбрать через EX5_ELEMENT_BITS. Матрица int32 при n = 16384 занимает 1 ГБ.
+void bench_kernel(const Options& opts) {
+    cout << "n\ttype\tloop_GMAC/s\tkernel_GMAC/s\tspeedup\tmatch" << endl;
+    for (int n = 64; n <= opts.max_n; n *= 2) {
+        bench_kernel_size<int8_t, int32_t>("int8->int32", n);
+        bench_kernel_size<int16_t, int32_t>("int16->int32", n);
+        bench_kernel_size<int32_t, int64_t>("int32->int64", n);
+    }
+}
+
+// Бенчмарк рассылки матрицы bench_size x bench_size элементов Element по кольцу из всех процессов:
+// прежняя передача целой матрицы от соседа к соседу, конвейерное кольцо с порциями
+// opts.chunk и MPI_Bcast, а также обе последние вместе с ядром для блока строк A процесса
+// (ring_compute, bcast_compute). Время — максимум по процессам, среднее по повторам.
+void bench_broadcast(int rank, int size, const Options& opts) {
+    const int n = opts.bench_size;
+    Matrix<Element> B(n, n);
+    if (rank == 0) {
+        initialize_matrix_B(B, 0, 0, MatrixValues{ n, true });
+    }
+    MPI_Comm ring_comm;
+    int dims[1] = { size };
+    int periods[1] = { 1 };
+    MPI_Cart_create(MPI_COMM_WORLD, 1, dims, periods, 0, &ring_comm);
+    int left, right;
+    MPI_Cart_shift(ring_comm, 0, 1, &left, &right);
+    const int chunk_rows = (int)clamp<size_t>(opts.chunk / n, 1, n);
+    const int reps = 5;
+
+    auto measure = [&](auto broadcast) {
+        broadcast(); // Прогрев
+        MPI_Barrier(ring_comm);
+        const double start = MPI_Wtime();
+        for (int rep = 0; rep < reps; rep++) {
+            broadcast();
+        }
+        double elapsed = (MPI_Wtime() - start) / reps;
+        MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, ring_comm);
+        return elapsed;
+    };
+    const double store_time = measure([&] {
+        if (rank == 0) {
+            MPI_Send(B.data.data(), n * n, mpi_type<Element>(), right, 0, ring_comm);
+        }
+        else {
+            MPI_Recv(B.data.data(), n * n, mpi_type<Element>(), left, 0, ring_comm, MPI_STATUS_IGNORE);
+            if (rank != size - 1) {
+                MPI_Send(B.data.data(), n * n, mpi_type<Element>(), right, 0, ring_comm);
+            }
         }
+    });
+    const double ring_time = measure([&] {
+        ring_broadcast_pipelined(B.data.data(), n, n, chunk_rows, ring_comm, left, right, [](int, int) {});
+    });
+    const double bcast_time = measure([&] { MPI_Bcast(B.data.data(), n * n, mpi_type<Element>(), 0, ring_comm); });
+
+    // Рассылка вместе с ядром для блока строк A процесса, как в ring_process
+    const int first_row = block_start(n, size, rank);
+    const int rows = block_start(n, size, rank + 1) - first_row;
+    Matrix<Element> A(rows, n);
+    initialize_matrix_A(A, first_row, 0, MatrixValues{ n, true });
+    vector<Accumulator> local_max(rows);
+    auto kernel = [&] { rows_times_matrix_max(A.data.data(), A.cols, rows, B.data.data(), n, n, local_max.data()); };
+    const double ring_compute_time = measure([&] {
+        ring_broadcast_pipelined(B.data.data(), n, n, chunk_rows, ring_comm, left, right,
+            [&](int chunk_first_row, int num_rows) {
+                if (chunk_first_row + num_rows == n) {
+                    kernel();
+                }
+            });
+    });
+    const double bcast_compute_time = measure([&] {
+        MPI_Bcast(B.data.data(), n * n, mpi_type<Element>(), 0, ring_comm);
+        kernel();
+    });
+
+    // Проверка, что B дошла до всех процессов целиком
+    long long checksum = 0;
+    for (Element value : B.data) {
+        checksum += value;
     }
+    long long checksums[2] = { checksum, -checksum };
+    MPI_Allreduce(MPI_IN_PLACE, checksums, 2, MPI_LONG_LONG, MPI_MAX, ring_comm);
+
+    if (rank == 0) {
+        cout << "p\tn\tbytes\tchunk_rows\tstore_forward_ms\tring_pipelined_ms\tbcast_ms\tring_compute_ms\t"
+            << "bcast_compute_ms\tmatch" << endl;
+        cout << size << "\t" << n << "\t" << (size_t)n * n * sizeof(Element) << "\t" << chunk_rows << "\t"
+            << store_time * 1e3 << "\t" << ring_time * 1e3 << "\t" << bcast_time * 1e3 << "\t"
+            << ring_compute_time * 1e3 << "\t" << bcast_compute_time * 1e3 << "\t"
+            << (checksums[0] == -checksums[1] ? "yes" : "NO") << endl;
+    }
+    MPI_Comm_free(&ring_comm);
 }
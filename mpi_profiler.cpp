@@ -0,0 +1,500 @@
+// Профилировщик MPI через интерфейс PMPI.
+//
+// Библиотека переопределяет функции обмена, ожидания и ввода-вывода MPI, которыми
+// пользуются программы, и вызывает настоящие реализации через PMPI_*. Вызовы без обмена
+// данными (коммуникаторы, топологии, типы, создание окон, MPI_Reduce_local, MPI_Wtime)
+// не профилируются. Для каждого вызова записываются время начала и длительность, объём
+// данных, партнёр (ранг в MPI_COMM_WORLD) и разделение времени на ожидание и передачу:
+//   - MPI_Recv: ожидание — PMPI_Probe до прихода сообщения, передача — сам приём;
+//   - MPI_Wait, MPI_Waitall, MPI_Waitany, MPI_Test: всё время — ожидание;
+//   - MPI_Win_fence: всё время — ожидание (синхронизация эпохи окна);
+//   - коллективные операции: ожидание — PMPI_Barrier перед операцией (опоздание других
+//     процессов), передача — сама операция. MPI_PROFILER_SYNC=0 отключает барьер;
+//   - остальные вызовы: всё время — передача.
+//
+// В MPI_Finalize каждый процесс пишет временную шкалу в формате Chrome trace
+// (<префикс>.rank<N>.json, открывается в chrome://tracing и Perfetto), а процесс 0 —
+// матрицу объёма двухточечных передач <префикс>.matrix.csv (байты от строки к столбцу)
+// и сводку по вызовам <префикс>.summary.csv. Префикс задаёт MPI_PROFILER_PREFIX
+// (по умолчанию mpi_profile), предел числа событий шкалы на процесс —
+// MPI_PROFILER_MAX_EVENTS (по умолчанию 1000000; сводка учитывает все вызовы).
+//
+// Исходники программ не меняются: библиотека подключается при сборке (см. MPI_PROFILE_TARGETS
+// в CMakeLists.txt), и определения из неё имеют приоритет над функциями libmpi.
+
+#include <mpi.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Профилируемые вызовы; порядок совпадает с CALL_NAMES
+enum Call {
+    SEND, RECV, ISEND, IRECV, SENDRECV, WAIT, WAITALL, WAITANY, TEST, PROBE, BARRIER, BCAST, REDUCE, ALLREDUCE,
+    IREDUCE, IALLREDUCE, GATHER, GATHERV, SCATTERV, FILE_READ_AT, FILE_READ_AT_ALL, FILE_WRITE_AT_ALL, WIN_FENCE,
+    NUM_CALLS
+};
+
+constexpr std::array<const char*, NUM_CALLS> CALL_NAMES = {
+    "MPI_Send", "MPI_Recv", "MPI_Isend", "MPI_Irecv", "MPI_Sendrecv", "MPI_Wait", "MPI_Waitall", "MPI_Waitany",
+    "MPI_Test", "MPI_Probe", "MPI_Barrier", "MPI_Bcast", "MPI_Reduce", "MPI_Allreduce", "MPI_Ireduce", "MPI_Iallreduce",
+    "MPI_Gather", "MPI_Gatherv", "MPI_Scatterv", "MPI_File_read_at", "MPI_File_read_at_all", "MPI_File_write_at_all",
+    "MPI_Win_fence"
+};
+
+// Событие временной шкалы; времена — секунды от общего начала после MPI_Init
+struct Event {
+    Call call;
+    double start;
+    double duration;
+    double wait;
+    long long bytes;
+    int peer; // Ранг партнёра в MPI_COMM_WORLD или -1 (коллективная операция без корня)
+};
+
+// Итоги вызова одного вида: число, время, ожидание, байты
+struct CallTotals {
+    double count = 0;
+    double time = 0;
+    double wait = 0;
+    double bytes = 0;
+};
+
+struct Profile {
+    bool active = false;
+    bool sync_collectives = true;
+    int rank = 0;
+    int size = 1;
+    double origin = 0;
+    std::size_t max_events = 1000000;
+    std::string prefix = "mpi_profile";
+    MPI_Group world_group = MPI_GROUP_NULL;
+    std::vector<Event> events;
+    std::array<CallTotals, NUM_CALLS> totals{};
+    std::vector<long long> sent_bytes; // Байты двухточечных передач этого процесса каждому партнёру
+};
+
+Profile profile;
+
+long long message_bytes(int count, MPI_Datatype datatype) {
+    int type_size = 0;
+    PMPI_Type_size(datatype, &type_size);
+    return (long long)count * type_size;
+}
+
+// Ранг процесса rank коммуникатора comm в MPI_COMM_WORLD
+int world_rank(MPI_Comm comm, int rank) {
+    if (rank < 0 || comm == MPI_COMM_WORLD) {
+        return rank;
+    }
+    MPI_Group group;
+    PMPI_Comm_group(comm, &group);
+    int world = MPI_UNDEFINED;
+    PMPI_Group_translate_ranks(group, 1, &rank, profile.world_group, &world);
+    PMPI_Group_free(&group);
+    return world == MPI_UNDEFINED ? -1 : world;
+}
+
+void record(Call call, double start, double end, double wait, long long bytes, int peer) {
+    if (!profile.active) {
+        return;
+    }
+    CallTotals& totals = profile.totals[call];
+    totals.count += 1;
+    totals.time += end - start;
+    totals.wait += wait;
+    totals.bytes += (double)bytes;
+    if (profile.events.size() < profile.max_events) {
+        profile.events.push_back({ call, start - profile.origin, end - start, wait, bytes, peer });
+    }
+}
+
+void count_sent(int peer, long long bytes) {
+    if (profile.active && peer >= 0 && peer < profile.size) {
+        profile.sent_bytes[peer] += bytes;
+    }
+}
+
+// Ожидание перед коллективной операцией: время в барьере, пока не придут остальные
+double collective_wait(MPI_Comm comm) {
+    if (!profile.active || !profile.sync_collectives) {
+        return 0;
+    }
+    const double start = PMPI_Wtime();
+    PMPI_Barrier(comm);
+    return PMPI_Wtime() - start;
+}
+
+void start_profile() {
+    PMPI_Comm_rank(MPI_COMM_WORLD, &profile.rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &profile.size);
+    PMPI_Comm_group(MPI_COMM_WORLD, &profile.world_group);
+    if (const char* prefix = std::getenv("MPI_PROFILER_PREFIX")) {
+        profile.prefix = prefix;
+    }
+    if (const char* max_events = std::getenv("MPI_PROFILER_MAX_EVENTS")) {
+        profile.max_events = std::strtoull(max_events, nullptr, 10);
+    }
+    if (const char* sync = std::getenv("MPI_PROFILER_SYNC")) {
+        profile.sync_collectives = std::string(sync) != "0";
+    }
+    profile.sent_bytes.assign(profile.size, 0);
+    profile.events.reserve(std::min<std::size_t>(profile.max_events, 1 << 16));
+
+    // Общее начало отсчёта, чтобы шкалы процессов совпадали
+    PMPI_Barrier(MPI_COMM_WORLD);
+    profile.origin = PMPI_Wtime();
+    profile.active = true;
+}
+
+FILE* open_output(const std::string& suffix) {
+    const std::string path = profile.prefix + suffix;
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "mpi_profiler: cannot open %s\n", path.c_str());
+    }
+    return file;
+}
+
+// Временная шкала процесса в формате Chrome trace: pid — ранг, времена в микросекундах
+void write_trace() {
+    FILE* file = open_output(".rank" + std::to_string(profile.rank) + ".json");
+    if (file == nullptr) {
+        return;
+    }
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"rank %d\"}}",
+        profile.rank, profile.rank);
+    for (const Event& event : profile.events) {
+        std::fprintf(file,
+            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,"
+            "\"args\":{\"bytes\":%lld,\"peer\":%d,\"wait_us\":%.3f,\"transfer_us\":%.3f}}",
+            CALL_NAMES[event.call], profile.rank, event.start * 1e6, event.duration * 1e6, event.bytes, event.peer,
+            event.wait * 1e6, (event.duration - event.wait) * 1e6);
+    }
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    std::fclose(file);
+}
+
+// Матрица объёма и сводка по вызовам всех процессов собираются на процессе 0
+void write_summary() {
+    std::vector<long long> matrix(profile.rank == 0 ? (std::size_t)profile.size * profile.size : 0);
+    PMPI_Gather(profile.sent_bytes.data(), profile.size, MPI_LONG_LONG, matrix.data(), profile.size, MPI_LONG_LONG,
+        0, MPI_COMM_WORLD);
+
+    std::vector<double> local(4 * NUM_CALLS);
+    for (int call = 0; call < NUM_CALLS; call++) {
+        const CallTotals& totals = profile.totals[call];
+        local[4 * call] = totals.count;
+        local[4 * call + 1] = totals.time;
+        local[4 * call + 2] = totals.wait;
+        local[4 * call + 3] = totals.bytes;
+    }
+    std::vector<double> all(profile.rank == 0 ? local.size() * profile.size : 0);
+    PMPI_Gather(local.data(), (int)local.size(), MPI_DOUBLE, all.data(), (int)local.size(), MPI_DOUBLE, 0,
+        MPI_COMM_WORLD);
+    if (profile.rank != 0) {
+        return;
+    }
+
+    if (FILE* file = open_output(".matrix.csv")) {
+        std::fprintf(file, "from\\to");
+        for (int to = 0; to < profile.size; to++) {
+            std::fprintf(file, ",%d", to);
+        }
+        std::fprintf(file, "\n");
+        for (int from = 0; from < profile.size; from++) {
+            std::fprintf(file, "%d", from);
+            for (int to = 0; to < profile.size; to++) {
+                std::fprintf(file, ",%lld", matrix[(std::size_t)from * profile.size + to]);
+            }
+            std::fprintf(file, "\n");
+        }
+        std::fclose(file);
+    }
+
+    if (FILE* file = open_output(".summary.csv")) {
+        std::fprintf(file, "rank,call,count,time_s,wait_s,transfer_s,bytes\n");
+        for (int rank = 0; rank < profile.size; rank++) {
+            for (int call = 0; call < NUM_CALLS; call++) {
+                const double* totals = all.data() + ((std::size_t)rank * NUM_CALLS + call) * 4;
+                if (totals[0] == 0) {
+                    continue;
+                }
+                std::fprintf(file, "%d,%s,%.0f,%.9f,%.9f,%.9f,%.0f\n", rank, CALL_NAMES[call], totals[0], totals[1],
+                    totals[2], totals[1] - totals[2], totals[3]);
+            }
+        }
+        std::fclose(file);
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int MPI_Init(int* argc, char*** argv) {
+    const int result = PMPI_Init(argc, argv);
+    start_profile();
+    return result;
+}
+
+int MPI_Init_thread(int* argc, char*** argv, int required, int* provided) {
+    const int result = PMPI_Init_thread(argc, argv, required, provided);
+    start_profile();
+    return result;
+}
+
+int MPI_Finalize() {
+    if (profile.active) {
+        profile.active = false;
+        write_trace();
+        write_summary();
+        PMPI_Group_free(&profile.world_group);
+    }
+    return PMPI_Finalize();
+}
+
+int MPI_Send(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Send(buf, count, datatype, dest, tag, comm);
+    const long long bytes = message_bytes(count, datatype);
+    const int peer = world_rank(comm, dest);
+    record(SEND, start, PMPI_Wtime(), 0, bytes, peer);
+    count_sent(peer, bytes);
+    return result;
+}
+
+int MPI_Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    // Сначала дожидаемся сообщения и принимаем именно его: с MPI_ANY_SOURCE порядок не меняется
+    MPI_Status probed;
+    if (source != MPI_PROC_NULL) {
+        PMPI_Probe(source, tag, comm, &probed);
+        source = probed.MPI_SOURCE;
+        tag = probed.MPI_TAG;
+    }
+    const double arrived = PMPI_Wtime();
+    MPI_Status local_status;
+    const int result = PMPI_Recv(buf, count, datatype, source, tag, comm,
+        status == MPI_STATUS_IGNORE ? &local_status : status);
+    const MPI_Status& received = status == MPI_STATUS_IGNORE ? local_status : *status;
+    int received_count = 0;
+    PMPI_Get_count(&received, datatype, &received_count);
+    record(RECV, start, PMPI_Wtime(), arrived - start, message_bytes(received_count, datatype),
+        world_rank(comm, source));
+    return result;
+}
+
+int MPI_Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm,
+    MPI_Request* request) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Isend(buf, count, datatype, dest, tag, comm, request);
+    const long long bytes = message_bytes(count, datatype);
+    const int peer = world_rank(comm, dest);
+    record(ISEND, start, PMPI_Wtime(), 0, bytes, peer);
+    count_sent(peer, bytes);
+    return result;
+}
+
+int MPI_Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm,
+    MPI_Request* request) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Irecv(buf, count, datatype, source, tag, comm, request);
+    record(IRECV, start, PMPI_Wtime(), 0, message_bytes(count, datatype), world_rank(comm, source));
+    return result;
+}
+
+int MPI_Sendrecv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, int dest, int sendtag, void* recvbuf,
+    int recvcount, MPI_Datatype recvtype, int source, int recvtag, MPI_Comm comm, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount, recvtype,
+        source, recvtag, comm, status);
+    const long long bytes = message_bytes(sendcount, sendtype);
+    const int peer = world_rank(comm, dest);
+    record(SENDRECV, start, PMPI_Wtime(), 0, bytes + message_bytes(recvcount, recvtype), peer);
+    count_sent(peer, bytes);
+    return result;
+}
+
+int MPI_Wait(MPI_Request* request, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Wait(request, status);
+    const double end = PMPI_Wtime();
+    record(WAIT, start, end, end - start, 0, -1);
+    return result;
+}
+
+int MPI_Waitall(int count, MPI_Request array_of_requests[], MPI_Status* array_of_statuses) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Waitall(count, array_of_requests, array_of_statuses);
+    const double end = PMPI_Wtime();
+    record(WAITALL, start, end, end - start, 0, -1);
+    return result;
+}
+
+int MPI_Waitany(int count, MPI_Request array_of_requests[], int* index, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Waitany(count, array_of_requests, index, status);
+    const double end = PMPI_Wtime();
+    record(WAITANY, start, end, end - start, 0, -1);
+    return result;
+}
+
+int MPI_Test(MPI_Request* request, int* flag, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Test(request, flag, status);
+    const double end = PMPI_Wtime();
+    record(TEST, start, end, end - start, 0, -1);
+    return result;
+}
+
+int MPI_Probe(int source, int tag, MPI_Comm comm, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Probe(source, tag, comm, status);
+    const double end = PMPI_Wtime();
+    record(PROBE, start, end, end - start, 0, world_rank(comm, source));
+    return result;
+}
+
+int MPI_Barrier(MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Barrier(comm);
+    const double end = PMPI_Wtime();
+    record(BARRIER, start, end, end - start, 0, -1);
+    return result;
+}
+
+int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const double wait = collective_wait(comm);
+    const int result = PMPI_Bcast(buffer, count, datatype, root, comm);
+    record(BCAST, start, PMPI_Wtime(), wait, message_bytes(count, datatype), world_rank(comm, root));
+    return result;
+}
+
+int MPI_Reduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root,
+    MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const double wait = collective_wait(comm);
+    const int result = PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    record(REDUCE, start, PMPI_Wtime(), wait, message_bytes(count, datatype), world_rank(comm, root));
+    return result;
+}
+
+int MPI_Allreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const double wait = collective_wait(comm);
+    const int result = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    record(ALLREDUCE, start, PMPI_Wtime(), wait, message_bytes(count, datatype), -1);
+    return result;
+}
+
+int MPI_Ireduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root,
+    MPI_Comm comm, MPI_Request* request) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Ireduce(sendbuf, recvbuf, count, datatype, op, root, comm, request);
+    record(IREDUCE, start, PMPI_Wtime(), 0, message_bytes(count, datatype), world_rank(comm, root));
+    return result;
+}
+
+int MPI_Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+    MPI_Request* request) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, comm, request);
+    record(IALLREDUCE, start, PMPI_Wtime(), 0, message_bytes(count, datatype), -1);
+    return result;
+}
+
+int MPI_Gather(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount,
+    MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const double wait = collective_wait(comm);
+    const int result = PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    int rank, size;
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    const long long bytes = rank == root ? message_bytes(recvcount, recvtype) * size : message_bytes(sendcount, sendtype);
+    record(GATHER, start, PMPI_Wtime(), wait, bytes, world_rank(comm, root));
+    return result;
+}
+
+int MPI_Gatherv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, const int recvcounts[],
+    const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const double wait = collective_wait(comm);
+    const int result = PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    int rank, size;
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    long long bytes = 0;
+    if (rank == root) {
+        for (int r = 0; r < size; r++) {
+            bytes += message_bytes(recvcounts[r], recvtype);
+        }
+    }
+    else {
+        bytes = message_bytes(sendcount, sendtype);
+    }
+    record(GATHERV, start, PMPI_Wtime(), wait, bytes, world_rank(comm, root));
+    return result;
+}
+
+int MPI_Scatterv(const void* sendbuf, const int sendcounts[], const int displs[], MPI_Datatype sendtype,
+    void* recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    const double start = PMPI_Wtime();
+    const double wait = collective_wait(comm);
+    const int result = PMPI_Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    int rank, size;
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    long long bytes = 0;
+    if (rank == root) {
+        for (int r = 0; r < size; r++) {
+            bytes += message_bytes(sendcounts[r], sendtype);
+        }
+    }
+    else {
+        bytes = message_bytes(recvcount, recvtype);
+    }
+    record(SCATTERV, start, PMPI_Wtime(), wait, bytes, world_rank(comm, root));
+    return result;
+}
+
+int MPI_File_read_at(MPI_File fh, MPI_Offset offset, void* buf, int count, MPI_Datatype datatype, MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_File_read_at(fh, offset, buf, count, datatype, status);
+    record(FILE_READ_AT, start, PMPI_Wtime(), 0, message_bytes(count, datatype), -1);
+    return result;
+}
+
+int MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void* buf, int count, MPI_Datatype datatype,
+    MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_File_read_at_all(fh, offset, buf, count, datatype, status);
+    record(FILE_READ_AT_ALL, start, PMPI_Wtime(), 0, message_bytes(count, datatype), -1);
+    return result;
+}
+
+int MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, const void* buf, int count, MPI_Datatype datatype,
+    MPI_Status* status) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_File_write_at_all(fh, offset, buf, count, datatype, status);
+    record(FILE_WRITE_AT_ALL, start, PMPI_Wtime(), 0, message_bytes(count, datatype), -1);
+    return result;
+}
+
+int MPI_Win_fence(int assert, MPI_Win win) {
+    const double start = PMPI_Wtime();
+    const int result = PMPI_Win_fence(assert, win);
+    const double end = PMPI_Wtime();
+    record(WIN_FENCE, start, end, end - start, 0, -1);
+    return result;
+}
+
+} // extern "C"
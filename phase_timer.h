@@ -0,0 +1,45 @@
+#pragma once
+
+// Замер фаз программ для бенчмарка масштабируемости.
+//
+// Таймер включается аргументом --phases. Каждая отметка ставит MPI_Barrier и засекает
+// MPI_Wtime, поэтому длительность фазы — время самого медленного процесса, а процесс 0
+// печатает её строкой "PHASE <имя> <секунды>", которую разбирает bench_driver. Выключенный
+// таймер ничего не делает и не меняет ни вывод, ни синхронизацию программы.
+
+#include <mpi.h>
+#include <iostream>
+
+namespace phase_timer {
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(bool enabled, MPI_Comm comm = MPI_COMM_WORLD) : enabled_(enabled), comm_(comm) {}
+
+    // Начало первой фазы
+    void start() {
+        if (!enabled_) return;
+        MPI_Barrier(comm_);
+        last_ = MPI_Wtime();
+    }
+
+    // Конец фазы name; следующая фаза начинается с этой же отметки
+    void mark(const char* name) {
+        if (!enabled_) return;
+        MPI_Barrier(comm_);
+        const double now = MPI_Wtime();
+        int rank;
+        MPI_Comm_rank(comm_, &rank);
+        if (rank == 0) {
+            std::cout << "PHASE " << name << " " << now - last_ << std::endl;
+        }
+        last_ = now;
+    }
+
+private:
+    bool enabled_;
+    MPI_Comm comm_;
+    double last_ = 0.0;
+};
+
+} // namespace phase_timer
@@ -0,0 +1,303 @@
+#pragma once
+
+// Библиотека пользовательских операций редукции MPI.
+//
+// Операции коммутативны, создаются один раз при первом запросе и освобождаются
+// автоматически в MPI_Finalize (через атрибут MPI_COMM_SELF). Функции операций
+// имеют настоящую сигнатуру MPI_User_function и выбирают ядро по MPI_Datatype:
+// int32, int64, float и double. Ядра векторизованы (векторные расширения GCC/Clang)
+// и выбираются по возможностям процессора во время выполнения.
+
+#include <mpi.h>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <span>
+
+namespace reduce_ops {
+
+// Все числа Фибоначчи 1, 2, 3, 5, ..., F(93), помещающиеся в uint64_t. Таблица дополнена
+// до 128 элементов значением UINT64_MAX, чтобы двоичный поиск шёл ровно 7 шагов.
+constexpr std::size_t FIBONACCI_TABLE_SIZE = 128;
+constexpr std::array<std::uint64_t, FIBONACCI_TABLE_SIZE> FIBONACCI_TABLE = [] {
+    std::array<std::uint64_t, FIBONACCI_TABLE_SIZE> table{};
+    table.fill(std::numeric_limits<std::uint64_t>::max());
+    std::uint64_t a = 1, b = 2;
+    std::size_t i = 0;
+    table[i++] = a;
+    for (;;) {
+        table[i++] = b;
+        if (b > std::numeric_limits<std::uint64_t>::max() - a) break; // Следующее число уже не помещается
+        const std::uint64_t next = a + b;
+        a = b;
+        b = next;
+    }
+    return table;
+}();
+static_assert(FIBONACCI_TABLE[0] == 1 && FIBONACCI_TABLE[1] == 2 && FIBONACCI_TABLE[91] == 12200160415121876738ull);
+
+// Минимальное число Фибоначчи, превосходящее num (0 для num <= 0).
+// Поиск без ветвлений по таблице; если ответ не помещается в T, возвращается
+// numeric_limits<T>::max().
+template <std::integral T>
+T find_min_fibonacci_greater_than(T num) {
+    if (num <= 0) return 0;
+
+    const std::uint64_t value = static_cast<std::uint64_t>(num);
+    std::size_t index = 0; // Количество элементов таблицы, не превосходящих value
+    for (std::size_t step = FIBONACCI_TABLE_SIZE / 2; step > 0; step /= 2) {
+        index += FIBONACCI_TABLE[index + step - 1] <= value ? step : 0;
+    }
+    const std::uint64_t result = FIBONACCI_TABLE[index];
+    return result > static_cast<std::uint64_t>(std::numeric_limits<T>::max()) ? std::numeric_limits<T>::max()
+                                                                             : static_cast<T>(result);
+}
+
+// Пакетная версия для целого массива: out[i] = find_min_fibonacci_greater_than(in[i])
+template <std::integral T>
+void find_min_fibonacci_greater_than(std::span<const T> in, std::span<T> out) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        out[i] = find_min_fibonacci_greater_than(in[i]);
+    }
+}
+
+// Пара "значение + индекс" для операции MinLoc
+template <typename T>
+struct MinLoc {
+    T value;
+    std::int64_t index;
+};
+
+// Операции библиотеки
+enum class Op {
+    Min, // Поэлементный минимум
+    MinLoc, // Минимум и индекс его источника (при равенстве — меньший индекс), типы MinLoc<T>
+    MinFibonacci, // Минимальное число Фибоначчи, превосходящее значения (только целые типы)
+    Count
+};
+
+namespace detail {
+
+// Поэлементный минимум по Bytes байт за шаг. Для float/double выражение a < b ? a : b
+// совпадает с semantics minps/minpd: если inout уже NaN, он и остаётся.
+template <typename T, std::size_t Bytes>
+__attribute__((always_inline)) inline void min_block(const T *in, T *inout, std::size_t n) {
+    typedef T Vector __attribute__((vector_size(Bytes)));
+    constexpr std::size_t LANES = Bytes / sizeof(T);
+    std::size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        Vector a, b;
+        std::memcpy(&a, in + i, Bytes);
+        std::memcpy(&b, inout + i, Bytes);
+        b = a < b ? a : b;
+        std::memcpy(inout + i, &b, Bytes);
+    }
+    for (; i < n; ++i) {
+        inout[i] = in[i] < inout[i] ? in[i] : inout[i];
+    }
+}
+
+template <typename T>
+void min_generic(const T *in, T *inout, std::size_t n) {
+    min_block<T, 16>(in, inout, n);
+}
+
+#if defined(__x86_64__)
+template <typename T>
+__attribute__((target("avx2"))) void min_avx2(const T *in, T *inout, std::size_t n) {
+    min_block<T, 32>(in, inout, n);
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) void min_avx512(const T *in, T *inout, std::size_t n) {
+    min_block<T, 64>(in, inout, n);
+}
+#endif
+
+// Самое широкое ядро минимума для типа T, выбирается один раз
+template <typename T>
+void min_kernel(const T *in, T *inout, std::size_t n) {
+    using Kernel = void (*)(const T *, T *, std::size_t);
+    static const Kernel kernel = [] {
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx512f")) return static_cast<Kernel>(min_avx512<T>);
+        if (__builtin_cpu_supports("avx2")) return static_cast<Kernel>(min_avx2<T>);
+#endif
+        return static_cast<Kernel>(min_generic<T>);
+    }();
+    kernel(in, inout, n);
+}
+
+template <typename T>
+void min_loc_kernel(const MinLoc<T> *in, MinLoc<T> *inout, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        const bool take = in[i].value < inout[i].value ||
+                          (in[i].value == inout[i].value && in[i].index < inout[i].index);
+        inout[i] = take ? in[i] : inout[i];
+    }
+}
+
+[[noreturn]] inline void unsupported_type() {
+    std::cerr << "reduce_ops: unsupported MPI_Datatype" << std::endl;
+    MPI_Abort(MPI_COMM_WORLD, 1);
+    std::abort();
+}
+
+inline bool is_int32(MPI_Datatype type) {
+    return type == MPI_INT32_T || (sizeof(int) == 4 && type == MPI_INT);
+}
+
+inline bool is_int64(MPI_Datatype type) {
+    return type == MPI_INT64_T || type == MPI_LONG_LONG || (sizeof(long) == 8 && type == MPI_LONG);
+}
+
+// Пользовательская операция "минимум" для int32/int64/float/double
+inline void min_function(void *in, void *inout, int *len, MPI_Datatype *type) {
+    const std::size_t n = static_cast<std::size_t>(*len);
+    if (is_int32(*type)) {
+        min_kernel(static_cast<const std::int32_t *>(in), static_cast<std::int32_t *>(inout), n);
+    } else if (is_int64(*type)) {
+        min_kernel(static_cast<const std::int64_t *>(in), static_cast<std::int64_t *>(inout), n);
+    } else if (*type == MPI_FLOAT) {
+        min_kernel(static_cast<const float *>(in), static_cast<float *>(inout), n);
+    } else if (*type == MPI_DOUBLE) {
+        min_kernel(static_cast<const double *>(in), static_cast<double *>(inout), n);
+    } else {
+        unsupported_type();
+    }
+}
+
+// Производные типы MinLoc<T>, созданные один раз
+template <typename T>
+MPI_Datatype &min_loc_type_slot() {
+    static MPI_Datatype type = MPI_DATATYPE_NULL;
+    return type;
+}
+
+inline void min_loc_function(void *in, void *inout, int *len, MPI_Datatype *type);
+
+// Операция "минимальное число Фибоначчи, превосходящее значение" для int32/int64.
+// Функция find_min_fibonacci_greater_than не убывает, поэтому минимум по процессам
+// от чисел Фибоначчи равен числу Фибоначчи от минимума значений. Редукция идёт по
+// исходным значениям, а таблица применяется один раз к результату (finalize).
+inline void min_fibonacci_function(void *in, void *inout, int *len, MPI_Datatype *type) {
+    if (!is_int32(*type) && !is_int64(*type)) {
+        unsupported_type();
+    }
+    min_function(in, inout, len, type);
+}
+
+// Кэш созданных операций; освобождается при удалении атрибута MPI_COMM_SELF в MPI_Finalize
+inline std::array<MPI_Op, static_cast<std::size_t>(Op::Count)> &op_cache() {
+    static std::array<MPI_Op, static_cast<std::size_t>(Op::Count)> ops = [] {
+        std::array<MPI_Op, static_cast<std::size_t>(Op::Count)> created{};
+        MPI_Op_create(min_function, 1, &created[static_cast<std::size_t>(Op::Min)]);
+        MPI_Op_create(min_loc_function, 1, &created[static_cast<std::size_t>(Op::MinLoc)]);
+        MPI_Op_create(min_fibonacci_function, 1, &created[static_cast<std::size_t>(Op::MinFibonacci)]);
+        return created;
+    }();
+    return ops;
+}
+
+inline int free_cached(MPI_Comm, int, void *, void *);
+
+// Регистрирует освобождение кэша в MPI_Finalize (один раз)
+inline void register_cleanup() {
+    static const bool registered = [] {
+        int keyval;
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, free_cached, &keyval, nullptr);
+        MPI_Comm_set_attr(MPI_COMM_SELF, keyval, nullptr);
+        MPI_Comm_free_keyval(&keyval);
+        return true;
+    }();
+    (void)registered;
+}
+
+} // namespace detail
+
+// Коммутативная операция библиотеки, созданная при первом обращении
+inline MPI_Op get(Op op) {
+    detail::register_cleanup();
+    return detail::op_cache()[static_cast<std::size_t>(op)];
+}
+
+// Соответствующий T встроенный тип MPI
+template <typename T>
+MPI_Datatype datatype_of() {
+    if constexpr (std::same_as<T, std::int32_t>) return MPI_INT32_T;
+    else if constexpr (std::same_as<T, std::int64_t>) return MPI_INT64_T;
+    else if constexpr (std::same_as<T, float>) return MPI_FLOAT;
+    else {
+        static_assert(std::same_as<T, double>, "reduce_ops supports int32, int64, float and double");
+        return MPI_DOUBLE;
+    }
+}
+
+// Производный тип MPI для MinLoc<T>, созданный при первом обращении
+template <typename T>
+MPI_Datatype min_loc_type() {
+    MPI_Datatype &type = detail::min_loc_type_slot<T>();
+    if (type == MPI_DATATYPE_NULL) {
+        detail::register_cleanup();
+        int lengths[2] = {1, 1};
+        MPI_Aint displacements[2] = {offsetof(MinLoc<T>, value), offsetof(MinLoc<T>, index)};
+        MPI_Datatype types[2] = {datatype_of<T>(), MPI_INT64_T};
+        MPI_Datatype unresized;
+        MPI_Type_create_struct(2, lengths, displacements, types, &unresized);
+        MPI_Type_create_resized(unresized, 0, sizeof(MinLoc<T>), &type);
+        MPI_Type_free(&unresized);
+        MPI_Type_commit(&type);
+    }
+    return type;
+}
+
+// Превращает результат редукции Op::MinFibonacci в числа Фибоначчи
+template <std::integral T>
+void finalize_min_fibonacci(std::span<T> values) {
+    find_min_fibonacci_greater_than<T>(values, values);
+}
+
+namespace detail {
+
+inline void min_loc_function(void *in, void *inout, int *len, MPI_Datatype *type) {
+    const std::size_t n = static_cast<std::size_t>(*len);
+    if (*type == min_loc_type_slot<std::int32_t>()) {
+        min_loc_kernel(static_cast<const MinLoc<std::int32_t> *>(in), static_cast<MinLoc<std::int32_t> *>(inout), n);
+    } else if (*type == min_loc_type_slot<std::int64_t>()) {
+        min_loc_kernel(static_cast<const MinLoc<std::int64_t> *>(in), static_cast<MinLoc<std::int64_t> *>(inout), n);
+    } else if (*type == min_loc_type_slot<float>()) {
+        min_loc_kernel(static_cast<const MinLoc<float> *>(in), static_cast<MinLoc<float> *>(inout), n);
+    } else if (*type == min_loc_type_slot<double>()) {
+        min_loc_kernel(static_cast<const MinLoc<double> *>(in), static_cast<MinLoc<double> *>(inout), n);
+    } else {
+        unsupported_type();
+    }
+}
+
+template <typename T>
+void free_min_loc_type() {
+    MPI_Datatype &type = min_loc_type_slot<T>();
+    if (type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&type);
+    }
+}
+
+inline int free_cached(MPI_Comm, int, void *, void *) {
+    for (MPI_Op &op : op_cache()) {
+        MPI_Op_free(&op);
+    }
+    free_min_loc_type<std::int32_t>();
+    free_min_loc_type<std::int64_t>();
+    free_min_loc_type<float>();
+    free_min_loc_type<double>();
+    return MPI_SUCCESS;
+}
+
+} // namespace detail
+
+} // namespace reduce_ops